@@ -0,0 +1,176 @@
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+
+#include "BlockSequences.hpp"
+
+using namespace std;
+
+const uint8_t BlockSequences::CODEC_RAW;
+const uint8_t BlockSequences::CODEC_PACKED;
+
+static void throw_corrupted()
+{
+  throw runtime_error("Invalid alignment block data (file is corrupted?)");
+}
+
+/* packed block: <alphabet size> <alphabet> <codes>, returns pointer to the codes */
+static const char * parse_packed_header(const char * data, size_t size, size_t chars_count,
+                                        size_t& alphabet_size, unsigned int& bits)
+{
+  if (size < 1)
+    throw_corrupted();
+
+  alphabet_size = (unsigned char) data[0];
+  if (!alphabet_size || alphabet_size > PackedCodec::MAX_ALPHABET || size < 1 + alphabet_size)
+    throw_corrupted();
+
+  bits = PackedCodec::bits(alphabet_size);
+  if (size - 1 - alphabet_size != PackedCodec::packed_size(chars_count, bits))
+    throw_corrupted();
+
+  return data + 1 + alphabet_size;
+}
+
+void BlockSequences::init(size_t count, size_t length, size_t block_sites,
+                          std::shared_ptr<const void> owner)
+{
+  assert(block_sites > 0 && owner);
+
+  _count = count;
+  _length = length;
+  _block_sites = block_sites;
+  _blocks.clear();
+  _blocks.reserve((length + block_sites - 1) / block_sites);
+  _owner = std::move(owner);
+}
+
+void BlockSequences::add_block(const char * data, size_t size, uint8_t codec)
+{
+  const auto start = _blocks.size() * _block_sites;
+  assert(start < _length);
+
+  Block b;
+  b.length = std::min(_block_sites, _length - start);
+  b.size = size;
+  b.codec = codec;
+
+  if (codec == CODEC_RAW)
+  {
+    if (size != _count * b.length)
+      throw_corrupted();
+    b.data = data;
+    b.alphabet = nullptr;
+    b.bits = 8;
+  }
+  else if (codec == CODEC_PACKED)
+  {
+    size_t alphabet_size;
+    b.data = parse_packed_header(data, size, _count * b.length, alphabet_size, b.bits);
+    b.alphabet = data + 1;
+  }
+  else
+    throw_corrupted();
+
+  _blocks.push_back(b);
+}
+
+void BlockSequences::clear()
+{
+  _count = _length = _block_sites = 0;
+  _blocks.clear();
+  _owner.reset();
+}
+
+size_t BlockSequences::mem_size() const
+{
+  size_t size = 0;
+  for (const auto& b: _blocks)
+    size += b.size;
+  return size;
+}
+
+void BlockSequences::decode(size_t index, size_t start, size_t count, char * out) const
+{
+  assert(index < _count && start + count <= _length);
+
+  const size_t end = start + count;
+  while (start < end)
+  {
+    const auto& b = _blocks[start / _block_sites];
+    const auto offset = start % _block_sites;
+    const auto n = std::min(b.length - offset, end - start);
+
+    if (b.codec == CODEC_RAW)
+      memcpy(out, b.data + index * b.length + offset, n);
+    else
+    {
+      PackedCodec::decode((const uint8_t *) b.data, index * b.length + offset, n,
+                          b.alphabet, b.bits, out);
+    }
+
+    start += n;
+    out += n;
+  }
+}
+
+std::string BlockSequences::decode(size_t index) const
+{
+  std::string s(_length, 0);
+  decode(index, 0, _length, &s[0]);
+  return s;
+}
+
+uint8_t BlockSequences::encode_block(const std::string& chars, bool compress, std::vector<char>& out)
+{
+  if (compress)
+  {
+    bool used[256] = {false};
+    PackedCodec::mark_used(chars.data(), chars.size(), used);
+
+    const auto alphabet = PackedCodec::alphabet(used);
+    if (!alphabet.empty() && alphabet.size() <= PackedCodec::MAX_ALPHABET)
+    {
+      const auto bits = PackedCodec::bits(alphabet.size());
+
+      out.push_back((char) alphabet.size());
+      out.insert(out.end(), alphabet.cbegin(), alphabet.cend());
+
+      const auto data_start = out.size();
+      out.resize(data_start + PackedCodec::packed_size(chars.size(), bits), 0);
+      PackedCodec::encode(chars.data(), chars.size(), alphabet, bits,
+                          (uint8_t *) out.data() + data_start);
+
+      return CODEC_PACKED;
+    }
+  }
+
+  out.insert(out.end(), chars.cbegin(), chars.cend());
+  return CODEC_RAW;
+}
+
+void BlockSequences::decode_block(const char * data, size_t size, uint8_t codec, std::string& chars)
+{
+  if (codec == CODEC_RAW)
+  {
+    if (size != chars.size())
+      throw_corrupted();
+    memcpy(&chars[0], data, size);
+  }
+  else if (codec == CODEC_PACKED)
+  {
+    size_t alphabet_size;
+    unsigned int bits;
+    auto packed = (const uint8_t *) parse_packed_header(data, size, chars.size(), alphabet_size, bits);
+
+    /* codes beyond the alphabet must not read past the block header */
+    char alphabet[PackedCodec::MAX_ALPHABET] = {0};
+    memcpy(alphabet, data + 1, alphabet_size);
+
+    if (PackedCodec::decode(packed, 0, chars.size(), alphabet, bits, &chars[0]) >= alphabet_size)
+      throw_corrupted();
+  }
+  else
+    throw_corrupted();
+}
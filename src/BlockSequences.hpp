@@ -0,0 +1,72 @@
+#ifndef RAXML_BLOCKSEQUENCES_HPP_
+#define RAXML_BLOCKSEQUENCES_HPP_
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include "PackedSequences.hpp"
+
+/* Read-only view of equal-length sequences stored in column blocks in external memory,
+ * e.g. in a memory-mapped RBA file. Every block contains the characters of all sequences
+ * (sequence-major), either plain or encoded with a block-local dictionary of up to 16
+ * characters (2 or 4 bits per site, see PackedCodec). Nothing is copied: characters are decoded on the fly
+ * from the referenced memory, which is kept alive by the owner handle. */
+class BlockSequences
+{
+public:
+  static const uint8_t CODEC_RAW    = 0;
+  static const uint8_t CODEC_PACKED = 1;
+
+  BlockSequences() : _count(0), _length(0), _block_sites(0) {}
+
+  void init(size_t count, size_t length, size_t block_sites, std::shared_ptr<const void> owner);
+
+  /* block data must stay valid as long as owner is alive; blocks are added in column order */
+  void add_block(const char * data, size_t size, uint8_t codec);
+  void clear();
+
+  bool empty() const { return !_owner; }
+  size_t size() const { return _count; }
+  size_t length() const { return _length; }
+  size_t block_sites() const { return _block_sites; }
+  size_t mem_size() const;
+
+  char at(size_t index, size_t site) const
+  {
+    const auto& b = _blocks[site / _block_sites];
+    const auto pos = index * b.length + site % _block_sites;
+    if (b.codec == CODEC_RAW)
+      return b.data[pos];
+    else
+      return PackedCodec::at((const uint8_t *) b.data, pos, b.alphabet, b.bits);
+  }
+
+  void decode(size_t index, size_t start, size_t count, char * out) const;
+  std::string decode(size_t index) const;
+
+  /* block encoding: append encoded chars to out and return the codec used */
+  static uint8_t encode_block(const std::string& chars, bool compress, std::vector<char>& out);
+  /* decode a whole block, chars must be resized to the expected block size */
+  static void decode_block(const char * data, size_t size, uint8_t codec, std::string& chars);
+
+private:
+  struct Block
+  {
+    const char * data;
+    const char * alphabet;
+    size_t size;
+    size_t length;         /* number of sites in this block */
+    uint8_t codec;
+    unsigned int bits;
+  };
+
+  size_t _count;
+  size_t _length;
+  size_t _block_sites;
+  std::vector<Block> _blocks;
+  std::shared_ptr<const void> _owner;
+};
+
+#endif /* RAXML_BLOCKSEQUENCES_HPP_ */
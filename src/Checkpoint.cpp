@@ -79,7 +79,8 @@ void CheckpointFile::write_tmp_bs_tree(const Tree& tree) const
 }
 
 CheckpointManager::CheckpointManager(const Options& opts) :
-    _active(opts.nofiles_mode ? false : true), _ckp_fname(opts.checkp_file())
+    _active(opts.nofiles_mode ? false : true), _ckp_fname(opts.checkp_file()), _new_spr_radius(0),
+    _best_fast_loglh(-INFINITY)
 {
   _checkp_file.opts = opts;
 }
@@ -96,6 +97,9 @@ Checkpoint& CheckpointManager::checkpoint(size_t ckp_id)
 
 void CheckpointManager::init_checkpoints(const Tree& tree, const ModelCRefMap& models)
 {
+  _coop_trees.assign(ParallelContext::num_local_groups(), ScoredTopology(-INFINITY, TreeTopology()));
+  _coop_adopt.assign(ParallelContext::num_local_groups(), ScoredTopology(-INFINITY, TreeTopology()));
+
   /* create one checkpoint per *local* worker */
   for (size_t i = 0; i < ParallelContext::num_local_groups(); ++i)
     _checkp_file.checkp_list.emplace_back();
@@ -188,7 +192,7 @@ void CheckpointManager::reset_search_state()
   ParallelContext::thread_barrier();
 };
 
-void CheckpointManager::save_ml_tree()
+void CheckpointManager::save_ml_tree(bool abandoned)
 {
   if (ParallelContext::group_master())
   {
@@ -206,6 +210,9 @@ void CheckpointManager::save_ml_tree()
 
     ml_trees.insert(ckp.tree_index, ScoredTopology(ckp.loglh(), ckp.tree.topology()));
 
+    if (abandoned)
+      _checkp_file.abandoned_trees.insert(ckp.tree_index);
+
     ckp.tree_index = 0;
 
     if (_active)
@@ -215,6 +222,23 @@ void CheckpointManager::save_ml_tree()
   }
 }
 
+void CheckpointManager::mark_abandoned()
+{
+  if (ParallelContext::group_master())
+  {
+    ParallelContext::UniqueLock lock;
+
+    _checkp_file.abandoned_trees.insert(checkpoint().tree_index);
+  }
+}
+
+bool CheckpointManager::abandoned(size_t tree_index) const
+{
+  ParallelContext::UniqueLock lock;
+
+  return _checkp_file.abandoned_trees.count(tree_index) > 0;
+}
+
 void CheckpointManager::save_bs_tree()
 {
   if (ParallelContext::group_master())
@@ -318,6 +342,10 @@ void CheckpointManager::gather_ml_trees()
       {
         BinaryStream bs((char*) buf, buf_size);
 
+        bs << _best_fast_loglh;
+
+        bs << _checkp_file.abandoned_trees;
+
         bs << _checkp_file.ml_trees;
 
         bs << _checkp_file.best_models;
@@ -326,6 +354,7 @@ void CheckpointManager::gather_ml_trees()
 
         // clear this batch of ML trees from the worker, since they will now be stored by master
         _checkp_file.ml_trees.clear();
+        _checkp_file.abandoned_trees.clear();
 
         return bs.pos();
       };
@@ -336,6 +365,11 @@ void CheckpointManager::gather_ml_trees()
        double old_score = _checkp_file.ml_trees.best_score();
        BinaryStream bs((char*) buf, buf_size);
 
+       _best_fast_loglh = std::max(_best_fast_loglh, bs.get<double>());
+
+       auto abandoned_trees = bs.get<IDSet>();
+       _checkp_file.abandoned_trees.insert(abandoned_trees.cbegin(), abandoned_trees.cend());
+
        bs >>  _checkp_file.ml_trees;
 
        if (_checkp_file.ml_trees.best_score() > old_score)
@@ -345,6 +379,83 @@ void CheckpointManager::gather_ml_trees()
   ParallelContext::mpi_gather_custom(worker_cb, master_cb);
 }
 
+void CheckpointManager::broadcast_best_models()
+{
+  /* after gather_ml_trees(), only master rank holds the best model estimates */
+  if (ParallelContext::master_thread())
+    ParallelContext::mpi_broadcast(_checkp_file.best_models);
+}
+
+void CheckpointManager::update_spr_radius(int radius)
+{
+  ParallelContext::UniqueLock lock;
+
+  if (!_new_spr_radius)
+    _new_spr_radius = radius;
+
+  /* single worker: no concurrent searches, so we can use the new radius right away */
+  if (ParallelContext::num_groups() == 1 && !_checkp_file.spr_radius)
+    _checkp_file.spr_radius = _new_spr_radius;
+}
+
+double CheckpointManager::best_fast_loglh() const
+{
+  ParallelContext::UniqueLock lock;
+  return _best_fast_loglh;
+}
+
+void CheckpointManager::update_fast_loglh(double loglh)
+{
+  ParallelContext::UniqueLock lock;
+  _best_fast_loglh = std::max(_best_fast_loglh, loglh);
+}
+
+void CheckpointManager::coop_publish(double loglh, const TreeTopology& topol, double margin)
+{
+  ParallelContext::UniqueLock lock;
+
+  auto group_id = ParallelContext::local_group_id();
+  _coop_trees.at(group_id) = ScoredTopology(loglh, topol);
+
+  /* adopt the best tree from other searches if we lag behind by more than margin */
+  auto& adopt = _coop_adopt.at(group_id);
+  adopt = ScoredTopology(-INFINITY, TreeTopology());
+  for (const auto& t: _coop_trees)
+  {
+    if (t.first - loglh > margin && t.first > adopt.first)
+      adopt = t;
+  }
+}
+
+void CheckpointManager::coop_reset()
+{
+  ParallelContext::UniqueLock lock;
+
+  auto group_id = ParallelContext::local_group_id();
+  _coop_trees.at(group_id) = ScoredTopology(-INFINITY, TreeTopology());
+  _coop_adopt.at(group_id) = ScoredTopology(-INFINITY, TreeTopology());
+}
+
+void CheckpointManager::sync_search_hints()
+{
+  /* NB: must be called by all threads on all ranks; values from master rank are used */
+  ParallelContext::global_thread_barrier();
+
+  int radius = _checkp_file.spr_radius ? _checkp_file.spr_radius : _new_spr_radius;
+  ParallelContext::global_master_broadcast(&radius, sizeof(int));
+
+  double fast_loglh = _best_fast_loglh;
+  ParallelContext::global_master_broadcast(&fast_loglh, sizeof(double));
+
+  if (ParallelContext::master_thread())
+  {
+    _checkp_file.spr_radius = radius;
+    _best_fast_loglh = fast_loglh;
+  }
+
+  ParallelContext::global_thread_barrier();
+}
+
 void CheckpointManager::gather_bs_trees()
 {
   if (ParallelContext::num_ranks() == 1 || ParallelContext::num_groups() == 1)
@@ -421,6 +532,12 @@ BasicBinaryStream& operator<<(BasicBinaryStream& stream, const CheckpointFile& c
 
   stream << ckpfile.bs_trees;
 
+  stream << ckpfile.spr_radius;
+
+  stream << ckpfile.abandoned_trees;
+
+  stream << ckpfile.triage_trees;
+
   return stream;
 }
 
@@ -464,6 +581,15 @@ BasicBinaryStream& operator>>(BasicBinaryStream& stream, CheckpointFile& ckpfile
 
   stream >> ckpfile.bs_trees;
 
+  if (ckpfile.version > 5)
+  {
+    stream >> ckpfile.spr_radius;
+    stream >> ckpfile.abandoned_trees;
+  }
+
+  if (ckpfile.version > 6)
+    stream >> ckpfile.triage_trees;
+
   return stream;
 }
 
@@ -485,9 +611,14 @@ void assign_models(Checkpoint& ckp, const TreeInfo& treeinfo)
 }
 
 void assign_models(TreeInfo& treeinfo, const Checkpoint& ckp)
+{
+  assign_models(treeinfo, ckp.models);
+}
+
+void assign_models(TreeInfo& treeinfo, const ModelMap& models)
 {
   const pllmod_treeinfo_t& pll_treeinfo = treeinfo.pll_treeinfo();
-  for (auto& m: ckp.models)
+  for (auto& m: models)
   {
     if (!pll_treeinfo.partitions[m.first])
       continue;
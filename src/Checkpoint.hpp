@@ -5,7 +5,7 @@
 #include "TreeInfo.hpp"
 #include "io/binary_io.hpp"
 
-constexpr int RAXML_CKP_VERSION = 5;
+constexpr int RAXML_CKP_VERSION = 7;
 constexpr int RAXML_CKP_MIN_SUPPORTED_VERSION = 5;
 
 struct MLTree
@@ -64,7 +64,8 @@ struct Checkpoint
 
 struct CheckpointFile
 {
-  CheckpointFile() : version(RAXML_CKP_VERSION), elapsed_seconds(0.), consumed_wh(0.) {}
+  CheckpointFile() : version(RAXML_CKP_VERSION), elapsed_seconds(0.), consumed_wh(0.),
+      spr_radius(0) {}
 
   int version;
   double elapsed_seconds;
@@ -77,6 +78,10 @@ struct CheckpointFile
   ScoredTopologyMap ml_trees;   /* ML trees from all individual searches*/
   ScoredTopologyMap bs_trees;   /* bootstrap replicate trees */
 
+  int spr_radius;               /* auto-detected SPR radius shared between searches (0 = unknown) */
+  IDSet abandoned_trees;        /* ML searches abandoned at FAST->SLOW transition */
+  IDVector triage_trees;        /* starting trees selected by triage (empty = no triage yet) */
+
   MLTree best_tree() const;
   Tree tree() const;
 
@@ -107,9 +112,13 @@ public:
 
   void update_and_write(const TreeInfo& treeinfo);
 
-  void save_ml_tree();
+  void save_ml_tree(bool abandoned = false);
   void save_bs_tree();
 
+  /* abandoned search is marked right away, such that the flag survives a restart */
+  void mark_abandoned();
+  bool abandoned(size_t tree_index) const;
+
   bool read() { return read(_ckp_fname); }
   bool read(const std::string& ckp_fname);
   void write() const { write(_ckp_fname); }
@@ -121,6 +130,23 @@ public:
 
   void gather_ml_trees();
   void gather_bs_trees();
+  void broadcast_best_models();
+
+  int spr_radius() const { return _checkp_file.spr_radius; }
+  void update_spr_radius(int radius);
+
+  void update_triage_trees(const IDVector& tree_ids) { _checkp_file.triage_trees = tree_ids; }
+
+  double best_fast_loglh() const;
+  void update_fast_loglh(double loglh);
+
+  void sync_search_hints();
+
+  /* cooperative search: exchange trees between concurrent searches on this rank */
+  void coop_publish(double loglh, const TreeTopology& topol, double margin);
+  void coop_reset();
+  const ScoredTopology& coop_adopt_tree() const
+  { return _coop_adopt.at(ParallelContext::local_group_id()); }
 
 private:
   bool _active;
@@ -128,6 +154,10 @@ private:
   CheckpointFile _checkp_file;
   IDSet _updated_models;
   SearchState _empty_search_state;
+  int _new_spr_radius;
+  double _best_fast_loglh;
+  std::vector<ScoredTopology> _coop_trees;    /* current tree of every local search */
+  std::vector<ScoredTopology> _coop_adopt;    /* tree to be adopted by every local search */
 
   void gather_model_params();
   std::string backup_fname() const { return _ckp_fname + ".bk"; }
@@ -142,6 +172,7 @@ BasicBinaryStream& operator>>(BasicBinaryStream& stream, CheckpointFile& ckpfile
 void assign_tree(Checkpoint& ckp, const TreeInfo& treeinfo);
 void assign_models(Checkpoint& ckp, const TreeInfo& treeinfo);
 void assign_models(TreeInfo& treeinfo, const Checkpoint& ckp);
+void assign_models(TreeInfo& treeinfo, const ModelMap& models);
 
 void assign(Checkpoint& ckp, const TreeInfo& treeinfo);
 void assign(TreeInfo& treeinfo, const Checkpoint& ckp);
@@ -81,6 +81,10 @@ static struct option long_options[] =
   {"site-weights",       required_argument, 0, 0 },  /*  56 */
   {"bs-write-msa",       no_argument, 0, 0 },        /*  57 */
   {"lh-epsilon-triplet", required_argument, 0, 0 },  /*  58 */
+  {"abandon-margin",     required_argument, 0, 0 },  /*  59 */
+  {"triage",             required_argument, 0, 0 },  /*  60 */
+  {"lh-epsilon-auto",    required_argument, 0, 0 },  /*  61 */
+  {"pars-collapse",      required_argument, 0, 0 },  /*  62 */
 
   { 0, 0, 0, 0 }
 };
@@ -270,15 +274,51 @@ void CommandLineParser::parse_options(int argc, char** argv, Options &opts)
   /* use probabilistic MSA _if available_ (e.g. CATG file was provided) */
   opts.use_prob_msa = true;
 
+  /* store state probabilities in double precision */
+  opts.use_prob_msa_float = false;
+
   /* use RBA partial loading whenever appropriate/possible */
   opts.use_rba_partload = true;
 
+  /* compress RBA column blocks (dictionary + 2/4-bit encoding) */
+  opts.use_rba_compression = true;
+
+  /* load whole RBA files via mmap (zero-copy) */
+  opts.use_rba_mmap = true;
+
+  /* keep one byte per alignment site (no 2/4-bit packing). NOTE: packing is applied
+   * only after the alignment has been loaded, compressed and checked, so it reduces
+   * memory footprint during tree search, but not the peak memory usage while loading */
+  opts.use_packed_msa = false;
+
   /* use new split-based constraint checking method -> slightly slower, but more reliable */
   opts.use_old_constraint = false;
 
   /* enable incremental CLV updates across pruned subtrees in SPR rounds */
   opts.use_spr_fastclv = true;
 
+  /* distribute alignment sites (and not SPR moves) across threads */
+  opts.use_spr_taxpar = false;
+
+  /* skip unchanged SPR neighborhoods: taxon-parallel mode (spr-taxpar) ONLY,
+   * has no effect on the default (site-parallel) SPR rounds */
+  opts.use_spr_cache = true;
+
+  /* optimize model parameters jointly across all partitions and threads */
+  opts.use_local_modopt = false;
+
+  /* do not write machine-readable search trace */
+  opts.use_search_trace = false;
+
+  /* build bootstrap parsimony starting trees on the original alignment */
+  opts.use_bs_rep_pars = false;
+
+  /* use full search schedule for bootstrap replicates */
+  opts.use_rapid_bs = false;
+
+  /* start bootstrap searches from initial model parameters */
+  opts.bs_model_init = BootstrapModelInit::initial;
+
   /* optimize model and branch lengths */
   opts.optimize_model = true;
   opts.optimize_brlen = true;
@@ -287,10 +327,27 @@ void CommandLineParser::parse_options(int argc, char** argv, Options &opts)
   opts.lh_epsilon = DEF_LH_EPSILON;
   opts.lh_epsilon_brlen_triplet = DEF_LH_EPSILON_BRLEN_TRIPLET;
 
+  /* default: fixed logLH epsilons, regardless of alignment size */
+  opts.lh_epsilon_adaptive = false;
+  opts.lh_min_rate = 0.;
+
   /* default: autodetect best SPR radius */
   opts.spr_radius = -1;
   opts.spr_cutoff = 1.0;
 
+  /* default: never abandon ML searches */
+  opts.abandon_margin = 0.;
+
+  /* default: full search from every starting tree */
+  opts.triage_top = 0;
+
+  /* default: use stepwise addition parsimony trees as is */
+  opts.pars_collapse_iters = 0;
+  opts.pars_collapse_seconds = 0.;
+
+  /* default: concurrent searches are independent */
+  opts.use_search_coop = false;
+
   /* bootstrapping / bootstopping */
   opts.bs_metrics.push_back(BranchSupportMetric::fbp);
   opts.bootstop_criterion = BootstopCriterion::autoMRE;
@@ -436,7 +493,6 @@ void CommandLineParser::parse_options(int argc, char** argv, Options &opts)
         if (!optarg || (strcasecmp(optarg, "off") != 0))
         {
           opts.use_prob_msa = true;
-          opts.use_pattern_compression = false;
           opts.use_tip_inner = false;
           opts.use_repeats = false;
         }
@@ -807,6 +863,20 @@ void CommandLineParser::parse_options(int argc, char** argv, Options &opts)
               opts.tbe_naive = false;
             else if (eopt == "rba-nopartload")
               opts.use_rba_partload = false;
+            else if (eopt == "rba-nocompress")
+              opts.use_rba_compression = false;
+            else if (eopt == "rba-mmap")
+              opts.use_rba_mmap = true;
+            else if (eopt == "rba-nommap")
+              opts.use_rba_mmap = false;
+            else if (eopt == "msa-packed")
+              opts.use_packed_msa = true;
+            else if (eopt == "msa-unpacked")
+              opts.use_packed_msa = false;
+            else if (eopt == "prob-msa-float")
+              opts.use_prob_msa_float = true;
+            else if (eopt == "prob-msa-double")
+              opts.use_prob_msa_float = false;
             else if (eopt == "energy-off")
               opts.use_energy_monitor = false;
             else if (eopt == "constraint-old")
@@ -821,10 +891,42 @@ void CommandLineParser::parse_options(int argc, char** argv, Options &opts)
               opts.use_bs_pars = true;
             else if (eopt == "bs-start-rand")
               opts.use_bs_pars = false;
+            else if (eopt == "bs-start-pars-rep")
+              opts.use_bs_rep_pars = true;
+            else if (eopt == "bs-start-pars-orig")
+              opts.use_bs_rep_pars = false;
             else if (eopt == "pars-par")
               opts.use_par_pars = true;
             else if (eopt == "pars-seq")
               opts.use_par_pars = false;
+            else if (eopt == "spr-taxpar")
+              opts.use_spr_taxpar = true;
+            else if (eopt == "spr-sitepar")
+              opts.use_spr_taxpar = false;
+            else if (eopt == "spr-cache")
+              opts.use_spr_cache = true;
+            else if (eopt == "spr-nocache")
+              opts.use_spr_cache = false;
+            else if (eopt == "modopt-local")
+              opts.use_local_modopt = true;
+            else if (eopt == "modopt-joint")
+              opts.use_local_modopt = false;
+            else if (eopt == "search-coop")
+              opts.use_search_coop = true;
+            else if (eopt == "search-indep")
+              opts.use_search_coop = false;
+            else if (eopt == "search-trace")
+              opts.use_search_trace = true;
+            else if (eopt == "bs-rapid")
+              opts.use_rapid_bs = true;
+            else if (eopt == "bs-full")
+              opts.use_rapid_bs = false;
+            else if (eopt == "bs-model-init")
+              opts.bs_model_init = BootstrapModelInit::initial;
+            else if (eopt == "bs-model-warm")
+              opts.bs_model_init = BootstrapModelInit::warm;
+            else if (eopt == "bs-model-fixed")
+              opts.bs_model_init = BootstrapModelInit::fixed;
             else if (eopt == "compat-v11")
             {
               compat_ver = 110;
@@ -956,7 +1058,60 @@ void CommandLineParser::parse_options(int argc, char** argv, Options &opts)
                                             string(optarg) +
                                             ", please provide a positive real number.");
         break;
-            
+
+      case 59: /* abandon ML searches lagging behind the best one by this margin */
+        if (strcasecmp(optarg, "off") == 0)
+          opts.abandon_margin = 0.;
+        else if (sscanf(optarg, "%lf", &opts.abandon_margin) != 1 || opts.abandon_margin <= 0.)
+        {
+          throw InvalidOptionValueException("Invalid search abandon margin: " + string(optarg) +
+                                            ", please provide a positive real number!");
+        }
+        break;
+
+      case 60: /* starting tree triage: full search for top-N starting trees only */
+        if (strcasecmp(optarg, "off") == 0)
+          opts.triage_top = 0;
+        else if (sscanf(optarg, "%u", &opts.triage_top) != 1 || opts.triage_top == 0)
+        {
+          throw InvalidOptionValueException("Invalid number of starting trees for triage: " +
+                                            string(optarg) + ", please provide a positive integer!");
+        }
+        break;
+
+      case 61: /* adaptive logLH epsilons + min. logLH improvement rate in SPR loops */
+        if (strcasecmp(optarg, "off") == 0)
+        {
+          opts.lh_epsilon_adaptive = false;
+          opts.lh_min_rate = 0.;
+        }
+        else if (strcasecmp(optarg, "on") == 0)
+        {
+          opts.lh_epsilon_adaptive = true;
+          opts.lh_min_rate = RAXML_ADAPTIVE_EPS_MIN_RATE;
+        }
+        else if (sscanf(optarg, "%lf", &opts.lh_min_rate) == 1 && opts.lh_min_rate >= 0.)
+          opts.lh_epsilon_adaptive = true;
+        else
+        {
+          throw InvalidOptionValueException("Invalid adaptive logLH epsilon setting: " + string(optarg) +
+                                            ", please provide on, off or a non-negative real number!");
+        }
+        break;
+
+      case 62: /* collapse-and-resolve improvement of parsimony starting trees: ITERATIONS[,SECONDS] */
+        opts.pars_collapse_seconds = 0.;
+        if (strcasecmp(optarg, "off") == 0)
+          opts.pars_collapse_iters = 0;
+        else if (sscanf(optarg, "%u,%lf", &opts.pars_collapse_iters, &opts.pars_collapse_seconds) < 1 ||
+                 opts.pars_collapse_iters == 0 || opts.pars_collapse_seconds < 0.)
+        {
+          throw InvalidOptionValueException("Invalid parsimony collapse-and-resolve budget: " + string(optarg) +
+                                            ", please provide a positive number of iterations, "
+                                            "optionally followed by a time limit in seconds!");
+        }
+        break;
+
       default:
         throw  OptionException("Internal error in option parsing");
     }
@@ -1076,6 +1231,17 @@ void CommandLineParser::print_help()
             "  --spr-radius           VALUE               SPR re-insertion radius for fast iterations (default: AUTO)\n"
             "  --spr-cutoff           VALUE | off         relative LH cutoff for descending into subtrees (default: 1.0)\n"
             "  --lh-epsilon-triplet   VALUE               log-likelihood epsilon for branch length triplet optimization (default: 1000)\n"
+            "  --abandon-margin       VALUE | off         abandon ML searches lagging behind the best one by VALUE logLH units\n"
+            "                                             after FAST SPR rounds (default: OFF)\n"
+            "  --triage               VALUE | off         quickly score all starting trees, and run full search only\n"
+            "                                             for the VALUE best ones plus 10% of the rest (default: OFF)\n"
+            "  --pars-collapse        ITER[,SEC] | off    improve parsimony ML starting trees (not bootstrap replicates)\n"
+            "                                             by ITER rounds of collapsing random inner branches and\n"
+            "                                             re-resolving them, optionally limited to SEC seconds per\n"
+            "                                             tree (NB: time limit breaks reproducibility) (default: OFF)\n"
+            "  --lh-epsilon-auto      on | off | RATE     scale logLH epsilons with the number of alignment patterns, and stop\n"
+            "                                             SPR rounds once logLH gain per second drops below RATE\n"
+            "                                             (on: RATE = 0.01, default: OFF)\n"
             "\n"
             "Bootstrapping options:\n"
             "  --bs-trees     VALUE                       number of bootstraps replicates\n"
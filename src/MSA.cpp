@@ -1,7 +1,10 @@
 #include <stdexcept>
 #include <algorithm>
+#include <limits>
+#include <unordered_map>
 
 #include "MSA.hpp"
+#include "util/threadutil.hpp"
 
 using namespace std;
 
@@ -21,13 +24,21 @@ MSA::MSA(const pll_msa_t *pll_msa) :
   update_pll_msa();
 }
 
+MSA::MSA(BlockSequences&& seqs) : _length(seqs.length()), _num_sites(seqs.length()),
+    _sequences(seqs.size()), _mapped(std::move(seqs)), _states(0), _pll_msa(nullptr), _dirty(false)
+{
+}
+
 MSA::MSA(MSA&& other) : _length(other._length), _num_sites(other._num_sites),
-    _sequences(move(other._sequences)), _labels(move(other._labels)),
+    _sequences(move(other._sequences)), _packed(move(other._packed)), _mapped(move(other._mapped)),
+    _labels(move(other._labels)),
     _label_id_map(move(other._label_id_map)), _weights(move(other._weights)),
     _probs(move(other._probs)), _local_seq_ranges(move(other._local_seq_ranges)),
     _states(other._states), _pll_msa(other._pll_msa), _dirty(other._dirty)
 {
   other._length = other._num_sites = 0;
+  other._packed.clear();
+  other._mapped.clear();
   other._pll_msa = nullptr;
   other._dirty = false;
 };
@@ -54,6 +65,8 @@ MSA& MSA::operator=(MSA&& other)
     _pll_msa = other._pll_msa;
     _weights = std::move(other._weights);
     _sequences = std::move(other._sequences);
+    _packed = std::move(other._packed);
+    _mapped = std::move(other._mapped);
     _labels = std::move(other._labels);
     _label_id_map = std::move(other._label_id_map);
     _probs = std::move(other._probs);
@@ -63,6 +76,8 @@ MSA& MSA::operator=(MSA&& other)
 
     // reset other
     other._length = other._num_sites = other._states = 0;
+    other._packed.clear();
+    other._mapped.clear();
     other._pll_msa = nullptr;
     other._dirty = false;
   }
@@ -83,10 +98,19 @@ void MSA::free_pll_msa() noexcept
 
 void MSA::append(const string& sequence, const string& header)
 {
+  append(string(sequence), header);
+}
+
+void MSA::append(string&& sequence, const string& header)
+{
+  assert(plain());
+
   if(_length && sequence.length() != (size_t) _length)
     throw runtime_error{string("Tried to insert sequence to MSA of unequal length: ") + sequence};
 
-  _sequences.push_back(sequence);
+  const auto seq_len = sequence.length();
+
+  _sequences.push_back(std::move(sequence));
 
   if (!header.empty())
   {
@@ -96,7 +120,7 @@ void MSA::append(const string& sequence, const string& header)
 
   if (!_length)
   {
-    _length = sequence.length();
+    _length = seq_len;
     if (!_num_sites)
       _num_sites = _length;
   }
@@ -104,50 +128,273 @@ void MSA::append(const string& sequence, const string& header)
   _dirty = true;
 }
 
-void MSA::compress_patterns(const pll_state_t * charmap, bool store_backmap)
+void MSA::compress_patterns(const pll_state_t * charmap, bool store_backmap,
+                            unsigned int num_threads)
 {
-  update_pll_msa();
+  assert(plain());
+  assert(size() && _length);
 
-  assert(_pll_msa->count && _pll_msa->length);
+  const size_t taxa = size();
+  const size_t uncompressed_length = _length;
 
-  size_t uncompressed_length = _pll_msa->length;
-  unsigned int * backmap_ptr = nullptr;
+  if (uncompressed_length > std::numeric_limits<unsigned int>::max())
+    throw runtime_error("Pattern compression failed: alignment is too long");
 
-  if (store_backmap || !_weights.empty())
+  /* characters mapping to the same state are interchangeable: replace all of them with
+   * the first one (in ASCII order), exactly as pll_compress_site_patterns() does */
+  char canon[256] = {0};
   {
-    _site_pattern_map.resize(uncompressed_length);
-    backmap_ptr = _site_pattern_map.data();
+    unordered_map<pll_state_t, char> state_char;
+    for (int c = 1; c < 256; ++c)
+    {
+      if (charmap[c])
+        canon[c] = state_char.emplace(charmap[c], (char) c).first->second;
+    }
   }
 
-  unsigned int * w = pll_compress_site_patterns_msa(_pll_msa,
-                                                    charmap,
-                                                    backmap_ptr);
+  num_threads = std::max(1u, std::min<unsigned int>(num_threads,
+                                                    uncompressed_length / RAXML_PATCOMP_MIN_SITES));
+
+  /* probabilistic MSA: columns are identical only if all state probabilities match as well */
+  const bool prob = probabilistic() && !_probs.empty();
+
+  /* 1. canonicalize characters and hash columns, in parallel over column blocks */
+  vector<uint64_t> col_hash(uncompressed_length);
+  parallel_blocks(uncompressed_length, num_threads,
+                  [&](size_t, size_t begin, size_t end)
+                  {
+                    std::fill(col_hash.begin() + begin, col_hash.begin() + end,
+                              14695981039346656037ULL);
+                    for (size_t i = 0; i < taxa; ++i)
+                    {
+                      auto& s = _sequences[i];
+                      for (size_t j = begin; j < end; ++j)
+                      {
+                        const auto c = canon[(unsigned char) s[j]];
+                        if (!c)
+                        {
+                          throw runtime_error("Pattern compression failed: invalid character '" +
+                                              string(1, s[j]) + "' in sequence " + to_string(i+1) +
+                                              " at position " + to_string(j+1));
+                        }
+                        s[j] = c;
+                        col_hash[j] = (col_hash[j] ^ (unsigned char) c) * 1099511628211ULL;
+                        if (prob)
+                          col_hash[j] = _probs.site_hash(i, j, col_hash[j]);
+                      }
+                    }
+                  });
+
+  auto col_equal = [this, taxa, prob](size_t a, size_t b) -> bool
+    {
+      for (size_t i = 0; i < taxa; ++i)
+      {
+        if (_sequences[i][a] != _sequences[i][b])
+          return false;
+        if (prob && !_probs.site_equal(i, a, b))
+          return false;
+      }
+      return true;
+    };
+
+  /* 2. find distinct columns within every block; site_rep[j] = first identical column */
+  typedef unordered_map<uint64_t, uintVector> HashSiteMap;
+  uintVector site_rep(uncompressed_length);
+  vector<uintVector> block_reps(num_threads);
+  parallel_blocks(uncompressed_length, num_threads,
+                  [&](size_t t, size_t begin, size_t end)
+                  {
+                    HashSiteMap seen;
+                    for (size_t j = begin; j < end; ++j)
+                    {
+                      auto& reps = seen[col_hash[j]];
+                      auto rep = std::find_if(reps.cbegin(), reps.cend(),
+                                              [&col_equal, j](unsigned int r) { return col_equal(r, j); });
+                      if (rep != reps.cend())
+                        site_rep[j] = *rep;
+                      else
+                      {
+                        site_rep[j] = j;
+                        reps.push_back(j);
+                        block_reps[t].push_back(j);
+                      }
+                    }
+                  });
+
+  /* 3. merge block representatives (in site order, hence deterministic) */
+  uintVector patterns;
+  {
+    HashSiteMap seen;
+    for (const auto& reps: block_reps)
+    {
+      for (auto j: reps)
+      {
+        auto& global_reps = seen[col_hash[j]];
+        auto rep = std::find_if(global_reps.cbegin(), global_reps.cend(),
+                                [&col_equal, j](unsigned int r) { return col_equal(r, j); });
+        if (rep != global_reps.cend())
+          site_rep[j] = *rep;
+        else
+        {
+          global_reps.push_back(j);
+          patterns.push_back(j);
+        }
+      }
+    }
+  }
+  block_reps.clear();
+  col_hash.clear();
+  col_hash.shrink_to_fit();
+
+  /* 4. patterns are sorted lexicographically (same order as libpll) */
+  std::sort(patterns.begin(), patterns.end(),
+            [this, taxa, prob](unsigned int a, unsigned int b) -> bool
+            {
+              for (size_t i = 0; i < taxa; ++i)
+              {
+                const auto ca = (unsigned char) _sequences[i][a];
+                const auto cb = (unsigned char) _sequences[i][b];
+                if (ca != cb)
+                  return ca < cb;
+              }
+              /* same characters, but different probabilities */
+              for (size_t i = 0; prob && i < taxa; ++i)
+              {
+                const auto cmp = _probs.site_compare(i, a, b);
+                if (cmp)
+                  return cmp < 0;
+              }
+              return false;
+            });
+
+  const size_t new_length = patterns.size();
+
+  /* site -> pattern index: block representatives point to the global representative,
+   * which in turn points to itself */
+  {
+    uintVector rep_pattern(uncompressed_length);
+    for (size_t k = 0; k < new_length; ++k)
+      rep_pattern[patterns[k]] = k;
 
-  if (!w)
-    libpll_check_error("Pattern compression failed: ", true);
+    for (size_t j = 0; j < uncompressed_length; ++j)
+      site_rep[j] = site_rep[site_rep[j]];
 
-  /* set new, compressed length which has been updated in pll_msa */
-  _length = _pll_msa->length;
+    for (size_t j = 0; j < uncompressed_length; ++j)
+      site_rep[j] = rep_pattern[site_rep[j]];
+  }
+  const auto& site_pattern = site_rep;
+  const bool need_backmap = store_backmap || !_weights.empty();
 
   if (_weights.empty())
-    _weights = WeightVector(w, w + _pll_msa->length);
+  {
+    _weights.assign(new_length, 0);
+    for (auto k: site_pattern)
+      _weights[k]++;
+  }
   else
   {
     /* external weights specified -> use site_pattern_map to generate a compressed weight vector */
     assert(_weights.size() == uncompressed_length);
-    assert(!_site_pattern_map.empty());
-    WeightVector new_weights(_length, 0);
-    for (size_t i = 0; i < _site_pattern_map.size(); ++i)
-      new_weights[_site_pattern_map[i]] += _weights[i];
+    WeightVector new_weights(new_length, 0);
+    for (size_t j = 0; j < uncompressed_length; ++j)
+      new_weights[site_pattern[j]] += _weights[j];
     _weights = std::move(new_weights);
   }
 
-  for (auto& entry : _sequences)
-    entry.resize(_length);
+  /* 5. copy pattern columns into the new sequences, in parallel over taxa */
+  free_pll_msa();
+  ProbMatrix comp_probs;
+  if (prob)
+    comp_probs.resize(taxa, new_length, _states, _probs.single_precision());
+  parallel_blocks(taxa, num_threads,
+                  [&](size_t, size_t begin, size_t end)
+                  {
+                    for (size_t i = begin; i < end; ++i)
+                    {
+                      auto& s = _sequences[i];
+                      string comp_seq(new_length, 0);
+                      for (size_t k = 0; k < new_length; ++k)
+                        comp_seq[k] = s[patterns[k]];
+                      s = std::move(comp_seq);
+
+                      if (prob)
+                      {
+                        for (size_t k = 0; k < new_length; ++k)
+                          comp_probs.copy_site(i, k, _probs, patterns[k]);
+                      }
+                    }
+                  });
+  if (prob)
+    _probs = std::move(comp_probs);
+
+  if (need_backmap)
+    _site_pattern_map.assign(site_pattern.cbegin(), site_pattern.cend());
+
+  _length = new_length;
+  _dirty = true;
+}
+
+std::string MSA::sequence(size_t index) const
+{
+  if (packed())
+    return _packed.decode(index);
+  else if (mapped())
+    return _mapped.decode(index);
+  else
+    return _sequences.at(index);
+}
+
+void MSA::sequence(size_t index, size_t start, size_t count, char * out) const
+{
+  assert(start + count <= _length);
 
-  _dirty = false;
+  if (packed())
+    _packed.decode(index, start, count, out);
+  else if (mapped())
+    _mapped.decode(index, start, count, out);
+  else
+    memcpy(out, _sequences.at(index).data() + start, count);
 }
 
+bool MSA::pack()
+{
+  if (packed())
+    return true;
+
+  /* mapped sequences do not use any heap memory */
+  if (_sequences.empty() || mapped())
+    return false;
+
+  /* pll_msa points into the plain sequence buffers */
+  free_pll_msa();
+
+  _dirty = true;
+
+  return _packed.pack(_sequences, _length, true);
+}
+
+void MSA::unpack()
+{
+  if (plain())
+    return;
+
+  for (size_t i = 0; i < _sequences.size(); ++i)
+    _sequences[i] = sequence(i);
+
+  _packed.clear();
+  _mapped.clear();
+  _dirty = true;
+}
+
+size_t MSA::seq_mem_size() const
+{
+  if (packed())
+    return _packed.mem_size();
+  else if (mapped())
+    return _mapped.mem_size();
+  else
+    return _sequences.size() * _length;
+}
 
 const pll_msa_t * MSA::pll_msa() const
 {
@@ -164,6 +411,7 @@ void MSA::update_pll_msa() const
   }
 
   assert(_labels.empty() || _labels.size() == _sequences.size());
+  assert(plain());
 
   if (_dirty)
   {
@@ -195,63 +443,27 @@ void MSA::update_pll_msa() const
   }
 }
 
-void MSA::states(size_t states)
+void MSA::states(size_t states, bool single_precision)
 {
   _states = states;
   if (size() > 0)
-  {
-    _probs.resize(size());
-    for (auto& v: _probs)
-    {
-      v.resize(_length * _states);
-    }
-  }
-}
-
-ProbVector::const_iterator MSA::probs(size_t index, size_t site) const
-{
-  return _probs.at(index).cbegin() + site * _states;
-}
-
-ProbVector::iterator MSA::probs(size_t index, size_t site)
-{
-  return _probs.at(index).begin() + site * _states;
+    _probs.resize(size(), _length, _states, single_precision);
+  else
+    _probs.clear();
 }
 
 bool MSA::normalized() const
 {
-  if (!probabilistic())
-    return true;
-
-  for (const auto& pv: _probs)
-  {
-    for (auto p: pv)
-    {
-      if (p > 1.)
-        return false;
-    }
-  }
-
-  return true;
+  return !probabilistic() || _probs.normalized();
 }
 
 doubleVector MSA::state_freqs() const
 {
   assert(_states > 0);
 
-  double sum = 0;
-  doubleVector freqs(_states, 0.);
-  for (const auto& pv: _probs)
-  {
-    for (auto p = pv.cbegin(); p != pv.cend();)
-    {
-      for (size_t i = 0; i < _states; ++i, ++p)
-      {
-        freqs[i] += *p;
-        sum += *p;
-      }
-    }
-  }
+  /* after pattern compression, every pattern must be counted as often as it occurs */
+  doubleVector freqs = _probs.state_sums(_weights);
+  const double sum = std::accumulate(freqs.cbegin(), freqs.cend(), 0.);
 
   assert(sum > 0.);
 
@@ -267,7 +479,7 @@ void MSA::remove_sites(const std::vector<size_t>& site_indices)
   if (site_indices.empty())
     return;
 
-  assert(_length);
+  assert(_length && plain());
 
   auto sorted_indicies = site_indices;
 
@@ -294,6 +506,25 @@ void MSA::remove_sites(const std::vector<size_t>& site_indices)
     s.resize(new_length);
   }
 
+  if (probabilistic() && !_probs.empty())
+  {
+    ProbMatrix new_probs;
+    new_probs.resize(size(), new_length, _states, _probs.single_precision());
+    for (size_t i = 0; i < size(); ++i)
+    {
+      size_t pos = 0;
+      auto ignore = sorted_indicies.cbegin();
+      for (size_t j = 0; j < _length; ++j)
+      {
+        if (ignore == sorted_indicies.cend() || j != *ignore)
+          new_probs.copy_site(i, pos++, _probs, j);
+        else
+          ignore++;
+      }
+    }
+    _probs = std::move(new_probs);
+  }
+
   if (!_weights.empty())
   {
     assert(_weights.size() == _length);
@@ -2,9 +2,9 @@
 #define RAXML_MSA_HPP_
 
 #include "common.h"
-
-typedef std::vector<double> ProbVector;
-typedef std::vector<ProbVector> ProbVectorList;
+#include "PackedSequences.hpp"
+#include "BlockSequences.hpp"
+#include "ProbMatrix.hpp"
 
 struct Range
 {
@@ -30,6 +30,7 @@ public:
   MSA(const RangeList& rl);
 
   MSA(const pll_msa_t * pll_msa);
+  MSA(BlockSequences&& seqs);
   MSA(MSA&& other);
   MSA(const MSA& other) = delete;
 
@@ -39,7 +40,9 @@ public:
   MSA& operator=(const MSA& other) = delete;
 
   void append(const std::string& sequence, const std::string& header = "");
-  void compress_patterns(const pll_state_t * charmap, bool store_backmap = false);
+  void append(std::string&& sequence, const std::string& header = "");
+  void compress_patterns(const pll_state_t * charmap, bool store_backmap = false,
+                         unsigned int num_threads = 1);
 
   bool empty() const { return _sequences.empty(); }
   size_t size() const { return _sequences.size(); }
@@ -54,19 +57,37 @@ public:
   const container& labels() const { return _labels; };
   const std::string& label(size_t index) const { return _labels.at(index); }
   const std::string& at(const std::string& label) const
-  { return _sequences.at(_label_id_map.at(label)); }
-  const std::string& at(size_t index) const { return _sequences.at(index); }
+  { return at(_label_id_map.at(label)); }
+  const std::string& at(size_t index) const { assert(plain()); return _sequences.at(index); }
   const std::string& operator[](const std::string& label) const { return at(label); }
   const std::string& operator[](size_t index) const { return at(index); }
-  std::string& operator[](size_t index) { return _sequences.at(index); }
+  std::string& operator[](size_t index) { assert(plain()); return _sequences.at(index); }
+
+  /* accessors below work with plain, packed and mapped sequence storage */
+  std::string sequence(size_t index) const;
+  void sequence(size_t index, size_t start, size_t count, char * out) const;
+  char site_char(size_t index, size_t site) const
+  {
+    return packed() ? _packed.at(index, site) :
+        (mapped() ? _mapped.at(index, site) : _sequences.at(index)[site]);
+  }
+
+  /* switch to compact storage (2 or 4 bits per site), returns false if the alignment
+   * has too many distinct characters. Packed MSA is read-only and has no pll_msa. */
+  bool pack();
+  void unpack();
+  bool packed() const { return !_packed.empty(); }
+  /* sequences reference external memory (e.g. mmap'ed RBA file), read-only as well */
+  bool mapped() const { return !_mapped.empty(); }
+  bool plain() const { return !packed() && !mapped(); }
+  size_t seq_mem_size() const;
 
   bool probabilistic() const { return _states > 0; }
   bool normalized() const;
   size_t states() const { return _states; }
-  void states(size_t states);
-  const ProbVector& probs(size_t index) const { return _probs.at(index); }
-  ProbVector::const_iterator probs(size_t index, size_t site) const;
-  ProbVector::iterator probs(size_t index, size_t site);
+  void states(size_t states, bool single_precision = false);
+  const ProbMatrix& probs() const { return _probs; }
+  ProbMatrix& probs() { return _probs; }
 
   doubleVector state_freqs() const;
 
@@ -95,11 +116,13 @@ private:
   size_t _length;
   size_t _num_sites;
   container _sequences;
+  PackedSequences _packed;
+  BlockSequences _mapped;
   container _labels;
   NameIdMap _label_id_map;
   WeightVector _weights;
   WeightVector _site_pattern_map;
-  ProbVectorList _probs;
+  ProbMatrix _probs;
   RangeList _local_seq_ranges;
   size_t _states;
   mutable pll_msa_t * _pll_msa;
@@ -4,8 +4,15 @@ using namespace std;
 
 Optimizer::Optimizer (const Options &opts) :
     _lh_epsilon(opts.lh_epsilon), _lh_epsilon_brlen_triplet(opts.lh_epsilon_brlen_triplet),
-    _spr_radius(opts.spr_radius), _spr_cutoff(opts.spr_cutoff)
+    _spr_radius(opts.spr_radius), _spr_cutoff(opts.spr_cutoff), _abandon_margin(opts.abandon_margin),
+    _lh_epsilon_adaptive(opts.lh_epsilon_adaptive), _lh_min_rate(opts.lh_min_rate), _eps_scale(1.),
+    _abandoned(false), _random_seed(opts.random_seed), _spr_rounds(0)
 {
+  /* trees can only be exchanged between searches running within the same MPI rank */
+  _use_search_coop = opts.use_search_coop && ParallelContext::num_local_groups() > 1 &&
+                     ParallelContext::ranks_per_group() == 1;
+
+  _trace.enable(opts.use_search_trace);
 }
 
 Optimizer::~Optimizer ()
@@ -40,11 +47,113 @@ double Optimizer::optimize_model(TreeInfo& treeinfo, double lh_epsilon)
   return new_loglh;
 }
 
-double Optimizer::optimize_topology(TreeInfo& treeinfo, CheckpointManager& cm)
+double Optimizer::spr_round(TreeInfo& treeinfo, spr_round_params& spr_params)
 {
-  const double fast_modopt_eps = 10.;
-  const double interim_modopt_eps = 3.;
-  const double final_modopt_eps = 0.1;
+  _spr_rounds++;
+  return treeinfo.spr_round(spr_params);
+}
+
+bool Optimizer::abandon_search(double loglh, CheckpointManager& cm) const
+{
+  /* compare with the best logLH observed at the same stage by other searches so far */
+  double abandon = (cm.best_fast_loglh() - loglh > _abandon_margin) ? 1. : 0.;
+
+  /* all threads of this worker must agree on the decision */
+  ParallelContext::parallel_reduce(&abandon, 1, PLLMOD_COMMON_REDUCE_MAX);
+
+  if (ParallelContext::group_master_thread())
+    cm.update_fast_loglh(loglh);
+
+  return abandon > 0.;
+}
+
+/* Adaptive epsilons: logLH differences between trees are noisier on larger alignments
+ * (roughly with the square root of the number of sites), so scale all epsilons accordingly.
+ * NB: depends on the alignment only, so the same epsilons are used after restart from checkpoint */
+void Optimizer::init_eps_scale(const TreeInfo& treeinfo)
+{
+  _eps_scale = 1.;
+
+  if (!_lh_epsilon_adaptive)
+    return;
+
+  const auto& pll_treeinfo = treeinfo.pll_treeinfo();
+  double pattern_count = 0.;
+  for (unsigned int p = 0; p < pll_treeinfo.partition_count; ++p)
+  {
+    /* partitions can be split among threads, sum up local slices */
+    if (pll_treeinfo.partitions[p])
+      pattern_count += pll_treeinfo.partitions[p]->sites;
+  }
+
+  /* in taxon-parallel mode, sites are not split: every thread has the full count already */
+  if (!treeinfo.taxon_parallel())
+    ParallelContext::parallel_reduce(&pattern_count, 1, PLLMOD_COMMON_REDUCE_SUM);
+
+  _eps_scale = max(1., sqrt(pattern_count / RAXML_ADAPTIVE_EPS_REF_PATTERNS));
+
+  LOG_VERB << "Adaptive logLH epsilon scaling factor: " << FMT_PREC3(_eps_scale)
+           << " (patterns: " << (size_t) pattern_count << ")" << endl;
+}
+
+/* Adaptive epsilons: check if the last SPR round was too slow given the logLH gain */
+bool Optimizer::low_gain_rate(double lh_gain, double seconds) const
+{
+  if (!_lh_epsilon_adaptive || _lh_min_rate <= 0.)
+    return false;
+
+  double low_rate = (seconds > 0. && lh_gain / seconds < _lh_min_rate * _eps_scale) ? 1. : 0.;
+
+  /* timings differ between threads, so make sure all threads of this worker agree */
+  ParallelContext::parallel_reduce(&low_rate, 1, PLLMOD_COMMON_REDUCE_MAX);
+
+  return low_rate > 0.;
+}
+
+/* Cooperative search: publish current tree, and if we lag far behind the best concurrent
+ * search, continue from its tree after applying a few random SPR moves */
+double Optimizer::coop_exchange(TreeInfo& treeinfo, CheckpointManager& cm, double loglh, int iter)
+{
+  if (ParallelContext::group_master_thread())
+    cm.coop_publish(loglh, treeinfo.tree().topology(), RAXML_SEARCH_COOP_MARGIN);
+
+  ParallelContext::thread_barrier();
+
+  const auto& adopt = cm.coop_adopt_tree();
+  const double adopt_loglh = adopt.first;
+  const bool adopted = !adopt.second.edges.empty();
+  if (adopted)
+  {
+    treeinfo.topology(adopt.second);
+    treeinfo.perturb_topology(RAXML_SEARCH_COOP_MOVES, RAXML_SEARCH_COOP_RADIUS,
+                              _random_seed + ParallelContext::group_id() * 1000003 + iter);
+  }
+
+  ParallelContext::thread_barrier();
+
+  if (adopted)
+  {
+    LOG_PROGRESS(loglh) << "Adopted tree from concurrent search (logLH: " << FMT_LH(adopt_loglh)
+                        << ")" << endl;
+    loglh = treeinfo.optimize_branches(_lh_epsilon * _eps_scale, 1);
+  }
+
+  return loglh;
+}
+
+/* Tree search schedule. Rapid variant (bootstrap replicates) uses the same steps with: fixed SPR
+ * radius, model optimization only at the end, a single SLOW SPR round bounded by the FAST radius,
+ * and looser LH epsilon */
+double Optimizer::optimize_topology(TreeInfo& treeinfo, CheckpointManager& cm, bool rapid)
+{
+  init_eps_scale(treeinfo);
+
+  const double fast_modopt_eps = 10. * _eps_scale;
+  const double interim_modopt_eps = 3. * _eps_scale;
+  const double modopt_eps = 1.0 * _eps_scale;
+  const double lh_epsilon = (rapid ? max(_lh_epsilon, RAXML_RAPID_BS_LH_EPSILON) : _lh_epsilon) *
+                            _eps_scale;
+  const double final_modopt_eps = rapid ? lh_epsilon : 0.1 * _eps_scale;
 
   SearchState local_search_state = cm.search_state();
   auto& search_state = ParallelContext::group_master_thread() ? cm.search_state() : local_search_state;
@@ -56,10 +165,14 @@ double Optimizer::optimize_topology(TreeInfo& treeinfo, CheckpointManager& cm)
   spr_round_params& spr_params = search_state.spr_params;
   int& best_fast_radius = search_state.fast_spr_radius;
 
-  spr_params.lh_epsilon_brlen_full = _lh_epsilon;
+  spr_params.lh_epsilon_brlen_full = lh_epsilon;
   spr_params.lh_epsilon_brlen_triplet = _lh_epsilon_brlen_triplet;
 
   CheckpointStep resume_step = search_state.step;
+  const size_t tree_index = cm.checkpoint().tree_index;
+
+  /* search might have been abandoned before restart from checkpoint */
+  _abandoned = resume_step == CheckpointStep::finish && cm.abandoned(tree_index);
 
   /* Compute initial LH of the starting tree */
   loglh = treeinfo.loglh();
@@ -72,22 +185,26 @@ double Optimizer::optimize_topology(TreeInfo& treeinfo, CheckpointManager& cm)
           return true;
         }
         else
-          return false;;
+          return false;
       };
 
   if (do_step(CheckpointStep::brlenOpt))
   {
     cm.update_and_write(treeinfo);
     LOG_PROGRESS(loglh) << "Initial branch length optimization" << endl;
+    _trace.start(loglh);
     loglh = treeinfo.optimize_branches(fast_modopt_eps, 1);
+    _trace.record(CheckpointStep::brlenOpt, tree_index, 0, 0, loglh);
   }
 
   /* Initial fast model optimization */
-  if (do_step(CheckpointStep::modOpt1))
+  if (do_step(CheckpointStep::modOpt1) && !rapid)
   {
     cm.update_and_write(treeinfo);
     LOG_PROGRESS(loglh) << "Model parameter optimization (eps = " << fast_modopt_eps << ")" << endl;
+    _trace.start(loglh);
     loglh = optimize_model(treeinfo, fast_modopt_eps);
+    _trace.record(CheckpointStep::modOpt1, tree_index, 0, 0, loglh);
 
     /* start spr rounds from the beginning */
     iter = 0;
@@ -99,11 +216,18 @@ double Optimizer::optimize_topology(TreeInfo& treeinfo, CheckpointManager& cm)
 
 //  treeinfo->counter = 0;
 
+  /* radius detected in a previous search (if any) */
+  const int shared_radius = cm.spr_radius();
+
   if (_spr_radius > 0)
     best_fast_radius = _spr_radius;
+  else if (rapid)
+    best_fast_radius = min(RAXML_RAPID_BS_SPR_RADIUS, radius_limit);
   else
   {
-    /* auto detect best radius for fast SPRs */
+    /* auto detect best radius for fast SPRs. If a radius was detected in a previous search,
+     * start with it: the next round (radius increased by radius_step) confirms it, and
+     * autodetection only goes on if this round still improves the likelihood */
 
     if (do_step(CheckpointStep::radiusDetect))
     {
@@ -111,7 +235,7 @@ double Optimizer::optimize_topology(TreeInfo& treeinfo, CheckpointManager& cm)
       {
         spr_params.thorough = 0;
         spr_params.radius_min = 1;
-        best_fast_radius = spr_params.radius_max = 5;
+        best_fast_radius = spr_params.radius_max = shared_radius > 0 ? shared_radius : radius_step;
         spr_params.ntopol_keep = 0;
         spr_params.subtree_cutoff = 0.;
       }
@@ -125,33 +249,46 @@ double Optimizer::optimize_topology(TreeInfo& treeinfo, CheckpointManager& cm)
         ++iter;
         LOG_PROGRESS(best_loglh) << "AUTODETECT spr round " << iter << " (radius: " <<
             spr_params.radius_max << ")" << endl;
-        loglh = treeinfo.spr_round(spr_params);
+        _trace.start(loglh);
+        loglh = spr_round(treeinfo, spr_params);
+        _trace.record(CheckpointStep::radiusDetect, tree_index, iter, spr_params.radius_max, loglh,
+                      treeinfo.spr_moves());
 
-        if (loglh - best_loglh > 0.1)
+        if (loglh - best_loglh > 0.1 * _eps_scale)
         {
           /* LH improved, try to increase the radius */
           best_fast_radius = spr_params.radius_max;
-          spr_params.radius_min += radius_step;
+          spr_params.radius_min = spr_params.radius_max + 1;
           spr_params.radius_max += radius_step;
           best_loglh = loglh;
         }
         else
           break;
       }
+
+      if (ParallelContext::group_master_thread())
+        cm.update_spr_radius(best_fast_radius);
     }
   }
 
   LOG_PROGRESS(loglh) << "SPR radius for FAST iterations: " << best_fast_radius << " (" <<
-                 (_spr_radius > 0 ? "user-specified" : "autodetect") << ")" << endl;
+                 (_spr_radius > 0 ? "user-specified" :
+                     (rapid ? "fixed" : (best_fast_radius == shared_radius ? "shared" : "autodetect")))
+                 << ")" << endl;
 
   if (do_step(CheckpointStep::modOpt2))
   {
     cm.update_and_write(treeinfo);
 
     /* optimize model parameters a bit more thoroughly */
-    LOG_PROGRESS(loglh) << "Model parameter optimization (eps = " <<
-                                                            interim_modopt_eps << ")" << endl;
-    loglh = optimize_model(treeinfo, interim_modopt_eps);
+    if (!rapid)
+    {
+      LOG_PROGRESS(loglh) << "Model parameter optimization (eps = " <<
+                                                              interim_modopt_eps << ")" << endl;
+      _trace.start(loglh);
+      loglh = optimize_model(treeinfo, interim_modopt_eps);
+      _trace.record(CheckpointStep::modOpt2, tree_index, 0, 0, loglh);
+    }
 
     /* reset iteration counter for fast SPRs */
     iter = 0;
@@ -176,24 +313,60 @@ double Optimizer::optimize_topology(TreeInfo& treeinfo, CheckpointManager& cm)
       old_loglh = loglh;
       LOG_PROGRESS(old_loglh) << (spr_params.thorough ? "SLOW" : "FAST") <<
           " spr round " << iter << " (radius: " << spr_params.radius_max << ")" << endl;
-      loglh = treeinfo.spr_round(spr_params);
+      _trace.start(old_loglh);
+      const double round_start = global_timer().elapsed_seconds();
+      loglh = spr_round(treeinfo, spr_params);
+      auto spr_moves = treeinfo.spr_moves();
 
       /* optimize ALL branches */
-      loglh = treeinfo.optimize_branches(_lh_epsilon, 1);
+      loglh = treeinfo.optimize_branches(lh_epsilon, 1);
+
+      if (_use_search_coop)
+        loglh = coop_exchange(treeinfo, cm, loglh, iter);
+
+      _trace.record(CheckpointStep::fastSPR, tree_index, iter, spr_params.radius_max, loglh,
+                    spr_moves);
+
+      if (loglh - old_loglh > lh_epsilon &&
+          low_gain_rate(loglh - old_loglh, global_timer().elapsed_seconds() - round_start))
+      {
+        LOG_PROGRESS(loglh) << "FAST spr rounds stopped: logLH gain rate below threshold" << endl;
+        break;
+      }
     }
-    while (loglh - old_loglh > _lh_epsilon);
+    while (loglh - old_loglh > lh_epsilon);
+
+    if (_use_search_coop && ParallelContext::group_master_thread())
+      cm.coop_reset();
   }
 
   if (do_step(CheckpointStep::modOpt3))
   {
+    /* FAST->SLOW transition: stop here if this search is far behind the others */
+    _abandoned = _abandon_margin > 0. && abandon_search(loglh, cm);
+    if (_abandoned)
+    {
+      LOG_PROGRESS(loglh) << "Search abandoned: logLH lags behind the best search by more than "
+                          << _abandon_margin << endl;
+      search_state.step = CheckpointStep::finish;
+      cm.mark_abandoned();
+      cm.update_and_write(treeinfo);
+      return loglh;
+    }
+
     cm.update_and_write(treeinfo);
-    LOG_PROGRESS(loglh) << "Model parameter optimization (eps = " << 1.0 << ")" << endl;
-    loglh = optimize_model(treeinfo, 1.0);
+    if (!rapid)
+    {
+      LOG_PROGRESS(loglh) << "Model parameter optimization (eps = " << modopt_eps << ")" << endl;
+      _trace.start(loglh);
+      loglh = optimize_model(treeinfo, modopt_eps);
+      _trace.record(CheckpointStep::modOpt3, tree_index, 0, 0, loglh);
+    }
 
     /* init slow SPRs */
     spr_params.thorough = 1;
     spr_params.radius_min = 1;
-    spr_params.radius_max = radius_step;
+    spr_params.radius_max = rapid ? best_fast_radius : radius_step;
     iter = 0;
   }
 
@@ -206,13 +379,28 @@ double Optimizer::optimize_topology(TreeInfo& treeinfo, CheckpointManager& cm)
       old_loglh = loglh;
       LOG_PROGRESS(old_loglh) << (spr_params.thorough ? "SLOW" : "FAST") <<
           " spr round " << iter << " (radius: " << spr_params.radius_max << ")" << endl;
-      loglh = treeinfo.spr_round(spr_params);
+      _trace.start(old_loglh);
+      const double round_start = global_timer().elapsed_seconds();
+      loglh = spr_round(treeinfo, spr_params);
+      auto spr_moves = treeinfo.spr_moves();
 
       /* optimize ALL branches */
-      loglh = treeinfo.optimize_branches(_lh_epsilon, 1);
+      loglh = treeinfo.optimize_branches(lh_epsilon, 1);
+
+      _trace.record(CheckpointStep::slowSPR, tree_index, iter, spr_params.radius_max, loglh,
+                    spr_moves);
 
-      bool impr = (loglh - old_loglh > _lh_epsilon);
-      if (impr)
+      /* rapid mode: single SLOW round */
+      if (rapid)
+        break;
+
+      bool impr = (loglh - old_loglh > lh_epsilon);
+      if (impr && low_gain_rate(loglh - old_loglh, global_timer().elapsed_seconds() - round_start))
+      {
+        LOG_PROGRESS(loglh) << "SLOW spr rounds stopped: logLH gain rate below threshold" << endl;
+        break;
+      }
+      else if (impr)
       {
         /* got improvement in thorough mode: reset min radius to 1 */
         spr_params.radius_min = 1;
@@ -235,7 +423,9 @@ double Optimizer::optimize_topology(TreeInfo& treeinfo, CheckpointManager& cm)
   {
     cm.update_and_write(treeinfo);
     LOG_PROGRESS(loglh) << "Model parameter optimization (eps = " << final_modopt_eps << ")" << endl;
+    _trace.start(loglh);
     loglh = optimize_model(treeinfo, final_modopt_eps);
+    _trace.record(CheckpointStep::modOpt4, tree_index, 0, 0, loglh);
   }
 
   if (do_step(CheckpointStep::finish))
@@ -244,6 +434,28 @@ double Optimizer::optimize_topology(TreeInfo& treeinfo, CheckpointManager& cm)
   return loglh;
 }
 
+/* Cheap score for starting tree triage: initial branch length optimization + one FAST SPR round */
+double Optimizer::quick_score(TreeInfo& treeinfo)
+{
+  const double fast_modopt_eps = 10.;
+
+  double loglh = treeinfo.optimize_branches(fast_modopt_eps, 1);
+
+  spr_round_params spr_params;
+  spr_params.thorough = 0;
+  spr_params.radius_min = 1;
+  spr_params.radius_max = _spr_radius > 0 ? _spr_radius : 5;
+  spr_params.ntopol_keep = 20;
+  spr_params.subtree_cutoff = _spr_cutoff;
+  spr_params.lh_epsilon_brlen_full = _lh_epsilon;
+  spr_params.lh_epsilon_brlen_triplet = _lh_epsilon_brlen_triplet;
+  spr_params.reset_cutoff_info(loglh);
+
+  spr_round(treeinfo, spr_params);
+
+  return treeinfo.optimize_branches(_lh_epsilon, 1);
+}
+
 double Optimizer::evaluate(TreeInfo& treeinfo, CheckpointManager& cm)
 {
   const double fast_modopt_eps = 10.;
@@ -266,7 +478,7 @@ double Optimizer::evaluate(TreeInfo& treeinfo, CheckpointManager& cm)
           return true;
         }
         else
-          return false;;
+          return false;
       };
 
   if (do_step(CheckpointStep::brlenOpt))
@@ -3,6 +3,7 @@
 
 #include "TreeInfo.hpp"
 #include "Checkpoint.hpp"
+#include "SearchTrace.hpp"
 
 class Optimizer
 {
@@ -13,13 +14,33 @@ public:
 
   double optimize_model(TreeInfo& treeinfo, double lh_epsilon);
   double optimize_model(TreeInfo& treeinfo) { return optimize_model(treeinfo, _lh_epsilon); };
-  double optimize_topology(TreeInfo& treeinfo, CheckpointManager& cm);
+  /* rapid = cheaper schedule for bootstrap replicates (see Optimizer.cpp) */
+  double optimize_topology(TreeInfo& treeinfo, CheckpointManager& cm, bool rapid = false);
+  double quick_score(TreeInfo& treeinfo);
   double evaluate(TreeInfo& treeinfo, CheckpointManager& cm);
+
+  bool abandoned() const { return _abandoned; }
+  unsigned int spr_rounds() const { return _spr_rounds; }
 private:
   double _lh_epsilon;
   double _lh_epsilon_brlen_triplet;
   int _spr_radius;
   double _spr_cutoff;
+  double _abandon_margin;
+  bool _lh_epsilon_adaptive;
+  double _lh_min_rate;
+  double _eps_scale;
+  bool _abandoned;
+  bool _use_search_coop;
+  unsigned long _random_seed;
+  SearchTrace _trace;
+  unsigned int _spr_rounds;
+
+  double spr_round(TreeInfo& treeinfo, spr_round_params& spr_params);
+  bool abandon_search(double loglh, CheckpointManager& cm) const;
+  void init_eps_scale(const TreeInfo& treeinfo);
+  bool low_gain_rate(double lh_gain, double seconds) const;
+  double coop_exchange(TreeInfo& treeinfo, CheckpointManager& cm, double loglh, int iter);
 };
 
 #endif /* RAXML_OPTIMIZER_H_ */
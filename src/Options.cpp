@@ -5,18 +5,22 @@
 using namespace std;
 
 Options::Options() : opt_version(RAXML_OPT_VERSION), cmdline(""), command(Command::none),
-use_tip_inner(true), use_pattern_compression(true), use_prob_msa(false), use_rate_scalers(false),
-use_repeats(true), use_rba_partload(true), use_energy_monitor(true), use_old_constraint(false),
-use_spr_fastclv(true), use_bs_pars(true), use_par_pars(true),
+use_tip_inner(true), use_pattern_compression(true), use_prob_msa(false), use_prob_msa_float(false), use_rate_scalers(false),
+use_repeats(true), use_rba_partload(true), use_rba_compression(true), use_rba_mmap(true), use_packed_msa(false), use_energy_monitor(true), use_old_constraint(false),
+use_spr_fastclv(true), use_bs_pars(true), use_bs_rep_pars(false), use_par_pars(true), use_spr_taxpar(false), use_spr_cache(true),
+use_local_modopt(false), use_rapid_bs(false), use_search_coop(false), use_search_trace(false),
 optimize_model(true), optimize_brlen(true), force_mode(false), safety_checks(SafetyCheck::all),
 redo_mode(false), nofiles_mode(false), write_interim_results(true), write_bs_msa(false),
 log_level(LogLevel::progress), msa_format(FileFormat::autodetect), data_type(DataType::autodetect),
 random_seed(0), start_trees(), lh_epsilon(DEF_LH_EPSILON), lh_epsilon_brlen_triplet(DEF_LH_EPSILON_BRLEN_TRIPLET),
-spr_radius(-1), spr_cutoff(1.0),
+lh_epsilon_adaptive(false), lh_min_rate(0.),
+spr_radius(-1), spr_cutoff(1.0), abandon_margin(0.), triage_top(0),
+pars_collapse_iters(0), pars_collapse_seconds(0.),
 brlen_linkage(PLLMOD_COMMON_BRLEN_SCALED), brlen_opt_method(PLLMOD_OPT_BLO_NEWTON_FAST),
 brlen_min(RAXML_BRLEN_MIN), brlen_max(RAXML_BRLEN_MAX),
 num_searches(1), terrace_maxsize(100),
 num_bootstraps(1000), bootstop_criterion(BootstopCriterion::none), bootstop_cutoff(0.03),
+bs_model_init(BootstrapModelInit::initial),
 bootstop_interval(RAXML_BOOTSTOP_INTERVAL), bootstop_permutations(RAXML_BOOTSTOP_PERMUTES),
 tbe_naive(false), consense_cutoff(ConsenseCutoff::MR), tree_file(""), constraint_tree_file(""),
 msa_file(""), model_file(""), weights_file(""), outfile_prefix(""),
@@ -64,6 +68,7 @@ void Options::set_default_outfiles()
   set_default_outfile(outfile_names.tmp_best_tree, "lastTree.TMP");
   set_default_outfile(outfile_names.tmp_ml_trees, "mlTrees.TMP");
   set_default_outfile(outfile_names.tmp_bs_trees, "bootstraps.TMP");
+  set_default_outfile(outfile_names.search_trace, "searchTrace");
 }
 
 std::string Options::checkp_file() const
@@ -74,6 +79,14 @@ std::string Options::checkp_file() const
     return outfile_names.checkpoint;
 }
 
+std::string Options::search_trace_file() const
+{
+  if (ParallelContext::num_ranks() > 1)
+    return outfile_names.search_trace + "." + to_string(ParallelContext::rank_id());
+  else
+    return outfile_names.search_trace;
+}
+
 
 const std::string& Options::support_tree_file(BranchSupportMetric bsm) const
 {
@@ -344,6 +357,13 @@ std::ostream& operator<<(std::ostream& stream, const Options& opts)
         break;
       case StartingTree::parsimony:
         stream << "parsimony" << " (" << it->second << ")";
+        if (opts.pars_collapse_iters > 0)
+        {
+          stream << " + collapse/resolve (" << opts.pars_collapse_iters << " iterations";
+          if (opts.pars_collapse_seconds > 0.)
+            stream << ", max. " << opts.pars_collapse_seconds << " s";
+          stream << ")";
+        }
         break;
       case StartingTree::user:
         stream << "user";
@@ -356,7 +376,8 @@ std::ostream& operator<<(std::ostream& stream, const Options& opts)
       opts.command == Command::bsmsa)
   {
     stream << "  bootstrap replicates: ";
-    stream << (opts.use_bs_pars ? "parsimony (" : "random (");
+    stream << (opts.use_bs_pars ? (opts.use_bs_rep_pars ? "parsimony on replicate (" : "parsimony (") :
+                                  "random (");
     if (opts.bootstop_criterion == BootstopCriterion::none)
       stream << opts.num_bootstraps << ")";
     else
@@ -379,6 +400,16 @@ std::ostream& operator<<(std::ostream& stream, const Options& opts)
       stream << ", cutoff: " << opts.bootstop_cutoff << ")";
     }
     stream << endl;
+
+    if (opts.use_rapid_bs)
+      stream << "  bootstrap search schedule: rapid" << endl;
+
+    if (opts.bs_model_init != BootstrapModelInit::initial)
+    {
+      stream << "  bootstrap model parameters: ML estimates (";
+      stream << (opts.bs_model_init == BootstrapModelInit::fixed ? "fixed" : "warm start") << ")";
+      stream << endl;
+    }
   }
 
   if (!opts.constraint_tree_file.empty())
@@ -414,9 +445,22 @@ std::ostream& operator<<(std::ostream& stream, const Options& opts)
     stream << "  per-rate scalers: " << (opts.use_rate_scalers ? "ON" : "OFF") << endl;
     stream << "  site repeats: " << (opts.use_repeats ? "ON" : "OFF") << endl;
 
+    if (opts.use_packed_msa)
+      stream << "  packed alignment storage: ON (after loading)" << endl;
+
+    if (opts.use_local_modopt)
+      stream << "  thread-local model optimization: ON" << endl;
+
     stream << "  logLH epsilon: " ;
     stream << "general: " << opts.lh_epsilon << ", ";
     stream << "brlen-triplet: " << opts.lh_epsilon_brlen_triplet;
+    if (opts.lh_epsilon_adaptive)
+    {
+      stream << " (ADAPTIVE";
+      if (opts.lh_min_rate > 0.)
+        stream << ", min. gain rate: " << opts.lh_min_rate << " logLH/s";
+      stream << ")";
+    }
     stream << endl;
 
     if (opts.command == Command::search || opts.command == Command::all ||
@@ -432,7 +476,25 @@ std::ostream& operator<<(std::ostream& stream, const Options& opts)
       else
         stream << "  spr subtree cutoff: OFF" << endl;
 
+      if (opts.triage_top > 0)
+        stream << "  starting tree triage: top " << opts.triage_top << endl;
+
+      if (opts.abandon_margin > 0.)
+        stream << "  abandon searches lagging by: " << opts.abandon_margin << " logLH units" << endl;
+
       stream << "  fast CLV updates: " << (opts.use_spr_fastclv ? "ON" : "OFF") << endl;
+
+      if (opts.use_search_coop)
+        stream << "  cooperative tree search: ON" << endl;
+
+      if (opts.use_search_trace)
+        stream << "  search trace: " << opts.search_trace_file() << endl;
+
+      if (opts.use_spr_taxpar)
+      {
+        stream << "  taxon-parallel SPR: ON" << endl;
+        stream << "  SPR move cache (taxon-parallel only): " << (opts.use_spr_cache ? "ON" : "OFF") << endl;
+      }
     }
 
     stream << "  branch lengths: ";
@@ -33,6 +33,7 @@ struct OutputFileNames
   std::string tmp_best_tree;
   std::string tmp_ml_trees;
   std::string tmp_bs_trees;
+  std::string search_trace;
 };
 
 class Options
@@ -54,14 +55,25 @@ public:
   bool use_tip_inner;
   bool use_pattern_compression;
   bool use_prob_msa;
+  bool use_prob_msa_float;
   bool use_rate_scalers;
   bool use_repeats;
   bool use_rba_partload;
+  bool use_rba_compression;
+  bool use_rba_mmap;
+  bool use_packed_msa;
   bool use_energy_monitor;
   bool use_old_constraint;
   bool use_spr_fastclv;
   bool use_bs_pars;
+  bool use_bs_rep_pars;
   bool use_par_pars;
+  bool use_spr_taxpar;
+  bool use_spr_cache;
+  bool use_local_modopt;
+  bool use_rapid_bs;
+  bool use_search_coop;
+  bool use_search_trace;
 
   bool optimize_model;
   bool optimize_brlen;
@@ -81,8 +93,14 @@ public:
   StartingTreeMap start_trees;
   double lh_epsilon;
   double lh_epsilon_brlen_triplet;
+  bool lh_epsilon_adaptive;             /* scale epsilons with alignment size */
+  double lh_min_rate;                   /* min. logLH gain per second in SPR loops (adaptive mode) */
   int spr_radius;
   double spr_cutoff;
+  double abandon_margin;
+  unsigned int triage_top;
+  unsigned int pars_collapse_iters;      /* collapse-and-resolve iterations per parsimony starting tree */
+  double pars_collapse_seconds;          /* time limit for the above per tree (not reproducible!) */
   int brlen_linkage;
   int brlen_opt_method;
   double brlen_min;
@@ -95,6 +113,7 @@ public:
   std::vector<BranchSupportMetric> bs_metrics;
   BootstopCriterion bootstop_criterion;
   double bootstop_cutoff;
+  BootstrapModelInit bs_model_init;
   unsigned int bootstop_interval;
   unsigned int bootstop_permutations;
 
@@ -156,6 +175,7 @@ public:
   const std::string tmp_best_tree_file() const { return outfile_names.tmp_best_tree; }
   const std::string tmp_ml_trees_file() const { return outfile_names.tmp_ml_trees; }
   const std::string tmp_bs_trees_file() const { return outfile_names.tmp_bs_trees; }
+  std::string search_trace_file() const;
 
   void set_default_outfiles();
 
@@ -0,0 +1,139 @@
+#include <cassert>
+#include <algorithm>
+
+#include "PackedSequences.hpp"
+
+using namespace std;
+
+const size_t PackedCodec::MAX_ALPHABET;
+
+void PackedCodec::mark_used(const char * chars, size_t count, bool used[256])
+{
+  for (size_t j = 0; j < count; ++j)
+    used[(unsigned char) chars[j]] = true;
+}
+
+std::vector<char> PackedCodec::alphabet(const bool used[256])
+{
+  vector<char> alphabet;
+  for (size_t c = 0; c < 256; ++c)
+  {
+    if (used[c])
+      alphabet.push_back((char) c);
+  }
+  return alphabet;
+}
+
+void PackedCodec::encode(const char * chars, size_t count, const std::vector<char>& alphabet,
+                         unsigned int bits, uint8_t * out)
+{
+  assert(alphabet.size() <= MAX_ALPHABET);
+
+  uint8_t code[256] = {0};
+  for (size_t i = 0; i < alphabet.size(); ++i)
+    code[(unsigned char) alphabet[i]] = (uint8_t) i;
+
+  const size_t per_byte = 8 / bits;
+  for (size_t j = 0; j < count; ++j)
+    out[j / per_byte] |= code[(unsigned char) chars[j]] << ((j % per_byte) * bits);
+}
+
+unsigned int PackedCodec::decode(const uint8_t * packed, size_t start, size_t count,
+                                 const char * alphabet, unsigned int bits, char * out)
+{
+  const size_t per_byte = 8 / bits;
+  const unsigned int mask = (1u << bits) - 1;
+  unsigned int max_code = 0;
+
+  size_t j = start;
+  const size_t end = start + count;
+
+  /* leading sites up to the next byte boundary */
+  for (; j < end && j % per_byte; ++j)
+  {
+    const auto c = (packed[j / per_byte] >> ((j % per_byte) * bits)) & mask;
+    max_code = std::max(max_code, c);
+    *out++ = alphabet[c];
+  }
+
+  /* whole bytes */
+  for (; j + per_byte <= end; j += per_byte)
+  {
+    unsigned int byte = packed[j / per_byte];
+    for (size_t k = 0; k < per_byte; ++k, byte >>= bits)
+    {
+      max_code = std::max(max_code, byte & mask);
+      *out++ = alphabet[byte & mask];
+    }
+  }
+
+  /* trailing sites */
+  for (; j < end; ++j)
+  {
+    const auto c = (packed[j / per_byte] >> ((j % per_byte) * bits)) & mask;
+    max_code = std::max(max_code, c);
+    *out++ = alphabet[c];
+  }
+
+  return max_code;
+}
+
+bool PackedSequences::pack(container& seqs, size_t length, bool release)
+{
+  clear();
+
+  /* collect the alphabet */
+  bool used[256] = {false};
+  for (const auto& s: seqs)
+  {
+    assert(s.length() == length);
+    PackedCodec::mark_used(s.data(), s.length(), used);
+  }
+
+  auto alphabet = PackedCodec::alphabet(used);
+  if (alphabet.empty() || alphabet.size() > PackedCodec::MAX_ALPHABET)
+    return false;
+
+  _bits = PackedCodec::bits(alphabet.size());
+  _alphabet = std::move(alphabet);
+  _count = seqs.size();
+  _length = length;
+
+  _row_bytes = PackedCodec::packed_size(_length, _bits);
+  _data.assign(_count * _row_bytes, 0);
+
+  for (size_t i = 0; i < _count; ++i)
+  {
+    auto& s = seqs[i];
+    PackedCodec::encode(s.data(), _length, _alphabet, _bits, _data.data() + i * _row_bytes);
+
+    if (release)
+      string().swap(s);
+  }
+
+  return true;
+}
+
+void PackedSequences::clear()
+{
+  _count = _length = _row_bytes = 0;
+  _bits = 0;
+  _alphabet.clear();
+  _data.clear();
+  _data.shrink_to_fit();
+}
+
+void PackedSequences::decode(size_t index, size_t start, size_t count, char * out) const
+{
+  assert(index < _count && start + count <= _length);
+
+  PackedCodec::decode(_data.data() + index * _row_bytes, start, count, _alphabet.data(), _bits, out);
+}
+
+std::string PackedSequences::decode(size_t index) const
+{
+  string s(_length, 0);
+  if (_length)
+    decode(index, 0, _length, &s[0]);
+  return s;
+}
@@ -0,0 +1,81 @@
+#ifndef RAXML_PACKEDSEQUENCES_HPP_
+#define RAXML_PACKEDSEQUENCES_HPP_
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/* 2/4-bit dictionary codec (shared with BlockSequences): every character is replaced by
+ * its index in a sorted alphabet of up to 16 characters, and codes are packed into bytes
+ * starting from the least significant bits */
+class PackedCodec
+{
+public:
+  static const size_t MAX_ALPHABET = 16;
+
+  static void mark_used(const char * chars, size_t count, bool used[256]);
+  static std::vector<char> alphabet(const bool used[256]);
+
+  static unsigned int bits(size_t alphabet_size) { return alphabet_size <= 4 ? 2 : 4; }
+  static size_t packed_size(size_t count, unsigned int bits)
+  {
+    const size_t per_byte = 8 / bits;
+    return (count + per_byte - 1) / per_byte;
+  }
+
+  /* out must hold packed_size(count, bits) zero-initialized bytes */
+  static void encode(const char * chars, size_t count, const std::vector<char>& alphabet,
+                     unsigned int bits, uint8_t * out);
+
+  /* decode sites [start, start+count) from packed, returns the largest code found */
+  static unsigned int decode(const uint8_t * packed, size_t start, size_t count,
+                             const char * alphabet, unsigned int bits, char * out);
+
+  static char at(const uint8_t * packed, size_t pos, const char * alphabet, unsigned int bits)
+  {
+    const auto per_byte = 8 / bits;
+    return alphabet[(packed[pos / per_byte] >> ((pos % per_byte) * bits)) & ((1u << bits) - 1)];
+  }
+};
+
+/* Compact storage for a set of equal-length sequences. Characters are encoded with
+ * a dictionary shared by all sequences: 2 bits per site if the alignment uses at most
+ * 4 distinct characters (e.g. DNA without ambiguities), and 4 bits per site for up to
+ * 16 distinct characters (e.g. DNA with gaps and IUPAC ambiguity codes).
+ * Encoding is lossless, sequences are decoded on the fly. */
+class PackedSequences
+{
+public:
+  typedef std::vector<std::string> container;
+
+  PackedSequences() : _count(0), _length(0), _bits(0), _row_bytes(0) {}
+
+  /* encode seqs, returns false if there are too many distinct characters;
+   * if release is set, original sequences are freed as soon as they are encoded */
+  bool pack(container& seqs, size_t length, bool release);
+  void clear();
+
+  bool empty() const { return _count == 0; }
+  size_t size() const { return _count; }
+  size_t length() const { return _length; }
+  unsigned int bits_per_site() const { return _bits; }
+  size_t mem_size() const { return _data.size(); }
+
+  char at(size_t index, size_t site) const
+  {
+    return PackedCodec::at(_data.data() + index * _row_bytes, site, _alphabet.data(), _bits);
+  }
+
+  void decode(size_t index, size_t start, size_t count, char * out) const;
+  std::string decode(size_t index) const;
+
+private:
+  size_t _count;
+  size_t _length;
+  unsigned int _bits;
+  size_t _row_bytes;
+  std::vector<char> _alphabet;   /* code -> character */
+  std::vector<uint8_t> _data;
+};
+
+#endif /* RAXML_PACKEDSEQUENCES_HPP_ */
@@ -25,6 +25,7 @@ MutexType ParallelContext::mtx;
 
 thread_local size_t ParallelContext::_local_thread_id = 0;
 thread_local ThreadGroup * ParallelContext::_thread_group = nullptr;
+thread_local size_t ParallelContext::_num_reductions = 0;
 std::vector<ThreadGroup> ParallelContext::_thread_groups;
 
 
@@ -442,6 +443,7 @@ void ParallelContext::mpi_reduce(double * data, size_t size, int op)
 void ParallelContext::parallel_reduce_cb(void * context, double * data, size_t size, int op)
 {
   RAXML_UNUSED(context);
+  _num_reductions++;
   if (ParallelContext::threads_per_group() > 1)
     ParallelContext::parallel_reduce(data, size, op);
   if (node_master())
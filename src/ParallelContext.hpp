@@ -81,6 +81,7 @@ public:
   static void parallel_reduce_cb(void * context, double * data, size_t size, int op);
   static void parallel_reduce(double * data, size_t size, int op);
   static void thread_reduce(double * data, size_t size, int op);
+  static size_t num_reductions() { return _num_reductions; }
   static void thread_broadcast(size_t source_id, void * data, size_t size);
   void thread_send_master(size_t source_id, void * data, size_t size) const;
 
@@ -175,6 +176,7 @@ private:
   static thread_local size_t _thread_id;
   static thread_local size_t _local_thread_id;
   static thread_local ThreadGroup * _thread_group;
+  static thread_local size_t _num_reductions;     /* number of libpll reduction callbacks */
 
   static std::vector<ThreadGroup> _thread_groups;
 
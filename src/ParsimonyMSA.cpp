@@ -1,3 +1,5 @@
+#include <numeric>
+
 #include "ParsimonyMSA.hpp"
 
 ParsimonyMSA::ParsimonyMSA (std::shared_ptr<PartitionedMSA> parted_msa, unsigned int attributes)
@@ -6,21 +8,44 @@ ParsimonyMSA::ParsimonyMSA (std::shared_ptr<PartitionedMSA> parted_msa, unsigned
   create_pll_partitions(attributes);
 }
 
-void ParsimonyMSA::init_pars_msa(std::shared_ptr<PartitionedMSA> orig_msa)
+ParsimonyMSA::ParsimonyMSA (std::shared_ptr<PartitionedMSA> parted_msa,
+                            const WeightVectorList& site_weights, unsigned int attributes)
+{
+  assert(site_weights.size() == parted_msa->part_count());
+
+  init_pars_msa(parted_msa, site_weights);
+  create_pll_partitions(attributes);
+}
+
+void ParsimonyMSA::init_pars_msa(std::shared_ptr<PartitionedMSA> orig_msa,
+                                 const WeightVectorList& site_weights)
 {
-  if (orig_msa->part_count() == 1)
+  if (orig_msa->part_count() == 1 && site_weights.empty())
   {
     _pars_msa = orig_msa;
     return;
   }
 
+  /* number of sites in the (reweighted) partition */
+  auto part_sites = [&orig_msa, &site_weights](size_t part_id) -> size_t
+      {
+        if (site_weights.empty())
+          return orig_msa->part_info(part_id).msa().num_sites();
+        else
+        {
+          const auto& w = site_weights.at(part_id);
+          return std::accumulate(w.cbegin(), w.cend(), (size_t) 0);
+        }
+      };
+
   // create 1 partition per datatype
   auto pars_msa = new PartitionedMSA(orig_msa->taxon_names());
   _pars_msa.reset(pars_msa);
 
   NameIdMap datatype_pinfo_map;
-  for (const auto& pinfo: orig_msa->part_list())
+  for (size_t p = 0; p < orig_msa->part_count(); ++p)
   {
+    const auto& pinfo = orig_msa->part_info(p);
     const auto& model = pinfo.model();
     auto data_type_name = model.data_type_name();
 
@@ -29,13 +54,13 @@ void ParsimonyMSA::init_pars_msa(std::shared_ptr<PartitionedMSA> orig_msa)
     {
       pars_msa->emplace_part_info(data_type_name, model.data_type(), model.to_string());
       auto& pars_pinfo = pars_msa->part_list().back();
-      pars_pinfo.msa(MSA(pinfo.msa().num_sites()));
+      pars_pinfo.msa(MSA(part_sites(p)));
       datatype_pinfo_map[data_type_name] = pars_msa->part_count()-1;
     }
     else
     {
       auto& msa = pars_msa->part_list().at(iter->second).msa();
-      msa.num_sites(msa.num_sites() + pinfo.msa().num_sites());
+      msa.num_sites(msa.num_sites() + part_sites(p));
     }
   }
 
@@ -49,14 +74,17 @@ void ParsimonyMSA::init_pars_msa(std::shared_ptr<PartitionedMSA> orig_msa)
       sequence.resize(pars_pinfo.msa().num_sites());
       size_t offset = 0;
 
-      for (const auto& pinfo: orig_msa->part_list())
+      for (size_t p = 0; p < orig_msa->part_count(); ++p)
       {
+        const auto& pinfo = orig_msa->part_info(p);
+
         // different datatype -> skip for now
         if (pinfo.model().data_type_name() != pars_datatype)
           continue;
 
-        const auto w = pinfo.msa().weights();
-        const auto s = pinfo.msa().at(j);
+        // NB: sites with zero weight in the replicate are dropped here
+        const auto& w = site_weights.empty() ? pinfo.msa().weights() : site_weights.at(p);
+        const auto s = pinfo.msa().sequence(j);
 
         if (w.empty())
         {
@@ -114,10 +142,13 @@ void ParsimonyMSA::create_pll_partitions(unsigned int attributes)
     if (!msa.weights().empty())
       pll_set_pattern_weights(partition, msa.weights().data());
 
-    /* set tip states */
+    /* set tip states (packed or mapped sequences have to be decoded first) */
+    std::string seq;
     for (size_t j = 0; j < msa.size(); ++j)
     {
-      pll_set_tip_states(partition, j, model.charmap(), msa.at(j).c_str());
+      if (!msa.plain())
+        seq = msa.sequence(j);
+      pll_set_tip_states(partition, j, model.charmap(), msa.plain() ? msa.at(j).c_str() : seq.c_str());
     }
 
     _pll_partitions.push_back(partition);
@@ -7,6 +7,10 @@ class ParsimonyMSA
 {
 public:
   ParsimonyMSA(std::shared_ptr<PartitionedMSA> parted_msa, unsigned int attributes);
+  /* parsimony MSA for a reweighted alignment (e.g. bootstrap replicate): site_weights are
+   * per-partition pattern weights which replace the original ones */
+  ParsimonyMSA(std::shared_ptr<PartitionedMSA> parted_msa, const WeightVectorList& site_weights,
+               unsigned int attributes);
 
   virtual
   ~ParsimonyMSA ();
@@ -21,7 +25,8 @@ private:
   std::shared_ptr<PartitionedMSA> _pars_msa;
   std::vector<pll_partition*> _pll_partitions;
 
-  void init_pars_msa(std::shared_ptr<PartitionedMSA> parted_msa);
+  void init_pars_msa(std::shared_ptr<PartitionedMSA> parted_msa,
+                     const WeightVectorList& site_weights = WeightVectorList());
 
   void create_pll_partitions(unsigned int attributes);
   void free_pll_partitions();
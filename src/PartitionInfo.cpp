@@ -1,3 +1,8 @@
+#include <random>
+#include <numeric>
+#include <algorithm>
+#include <unordered_set>
+
 #include "PartitionInfo.hpp"
 
 #include "Options.hpp"
@@ -14,6 +19,80 @@ size_t PartitionInfo::length() const
   return st.pattern_count ? st.pattern_count : st.site_count;
 }
 
+double PartitionInfo::repeats_ratio() const
+{
+  if (_repeats_ratio > 0.)
+    return _repeats_ratio;
+
+  const size_t taxa = _msa.size();
+  const size_t sites = _msa.length();
+
+  if (taxa < 4 || !sites)
+  {
+    /* sequences not loaded (e.g. RBA partial loading from a file without stored estimate) */
+    if (!sites && stats().site_count > 0)
+    {
+      LOG_VERB << "Partition " << _name << ": site repeats ratio is not available, "
+          "load balancing assumes no repeats" << endl;
+    }
+    return 1.;
+  }
+
+  /* Site repeats allow to skip CLV entries which share the same subtree pattern. Here, we
+   * estimate the fraction of unique subtree patterns by projecting a sample of alignment
+   * columns onto random taxon subsets of size 2, 4, 8, ..., which roughly corresponds to the
+   * subtree sizes in a balanced tree. Random subsets contain less similar sequences than real
+   * subtrees, so the estimate is conservative. The random seed is fixed to ensure that all
+   * ranks compute the same estimate and thus the same site distribution.
+   */
+  const size_t sample_sites = std::min(sites, (size_t) RAXML_REPEATS_SAMPLE_SITES);
+  const size_t site_stride = sites / sample_sites;
+
+  std::mt19937 gen(sites * taxa);
+  IDVector taxa_perm(taxa);
+  std::iota(taxa_perm.begin(), taxa_perm.end(), 0);
+
+  double unique_sum = 0.;
+  double total_sum = 0.;
+  double level_ratio = 0.;
+  for (size_t subtree_size = 2; subtree_size < taxa; subtree_size *= 2)
+  {
+    /* number of inner nodes with subtree of this size in a balanced tree */
+    const double level_nodes = ((double) taxa) / subtree_size;
+
+    /* once all subtree patterns are unique, larger subtrees won't have repeats either */
+    if (level_ratio < RAXML_REPEATS_MAX_RATIO)
+    {
+      size_t unique_count = 0;
+      std::unordered_set<std::string> patterns;
+      std::string pattern(subtree_size, 0);
+      for (size_t r = 0; r < RAXML_REPEATS_SAMPLE_SUBTREES; ++r)
+      {
+        std::shuffle(taxa_perm.begin(), taxa_perm.end(), gen);
+        patterns.clear();
+        for (size_t s = 0; s < sample_sites; ++s)
+        {
+          const auto site = s * site_stride;
+          for (size_t j = 0; j < subtree_size; ++j)
+            pattern[j] = _msa.site_char(taxa_perm[j], site);
+          patterns.insert(pattern);
+        }
+        unique_count += patterns.size();
+      }
+      level_ratio = ((double) unique_count) / (sample_sites * RAXML_REPEATS_SAMPLE_SUBTREES);
+    }
+    else
+      level_ratio = 1.;
+
+    unique_sum += level_ratio * level_nodes;
+    total_sum += level_nodes;
+  }
+
+  _repeats_ratio = total_sum > 0. ? unique_sum / total_sum : 1.;
+
+  return _repeats_ratio;
+}
+
 size_t PartitionInfo::taxon_clv_size(bool partial) const
 {
   auto sites = partial ? (_msa.num_patterns() ? _msa.num_patterns() : _msa.num_sites()) : length();
@@ -74,9 +153,10 @@ size_t PartitionInfo::mark_partition_sites(unsigned int part_num, std::vector<un
   return sites_assigned;
 }
 
-void PartitionInfo::compress_patterns(bool store_backmap)
+void PartitionInfo::compress_patterns(bool store_backmap, unsigned int num_threads)
 {
-  _msa.compress_patterns(model().charmap(), store_backmap);
+  _msa.compress_patterns(model().charmap(), store_backmap, num_threads);
+  _repeats_ratio = -1.;
 }
 
 pllmod_msa_stats_t * PartitionInfo::compute_stats(unsigned long stats_mask) const
@@ -51,23 +51,24 @@ class PartitionInfo
 {
 public:
   PartitionInfo () :
-    _name(""), _range_string(""), _model(), _msa(), _stats() {};
+    _name(""), _range_string(""), _model(), _msa(), _stats(), _repeats_ratio(-1.) {};
 
   PartitionInfo (const std::string &name, DataType data_type,
                  const std::string &model_string, const std::string &range_string = "") :
     _name(name), _range_string(range_string), _model(data_type, model_string), _msa(),
-    _stats() {};
+    _stats(), _repeats_ratio(-1.) {};
 
   PartitionInfo (const std::string &name, const PartitionStats &stats,
                  const Model &model, const std::string &range_string = "") :
     _name(name), _range_string(range_string), _model(model), _msa(),
-    _stats(stats) {};
+    _stats(stats), _repeats_ratio(-1.) {};
 
   virtual ~PartitionInfo ();
 
   PartitionInfo (PartitionInfo&& other) : _name(std::move(other._name)),
       _range_string(std::move(other._range_string)),  _model(std::move(other._model)),
-      _msa(std::move(other._msa)), _stats(std::move(other._stats))
+      _msa(std::move(other._msa)), _stats(std::move(other._stats)),
+      _repeats_ratio(other._repeats_ratio)
   {
     other._stats = PartitionStats();
   }
@@ -84,11 +85,15 @@ public:
 
   size_t length() const;
 
+  /* estimated fraction of inner CLV entries to be computed when site repeats are enabled */
+  double repeats_ratio() const;
+
   /* given in elements (NOT in bytes) */
   size_t taxon_clv_size(bool partial = false) const;
 
   // setters
-  void msa(MSA&& msa) { _msa = std::move(msa); };
+  void msa(MSA&& msa) { _msa = std::move(msa); _repeats_ratio = -1.; };
+  void repeats_ratio(double value) { _repeats_ratio = value; };
   void model(Model&& model) { _model = std::move(model); };
   void model(const Model& model) { _model = model; };
   void name(const std::string& value) { _name = value; };
@@ -96,7 +101,7 @@ public:
 
   // operations
   size_t mark_partition_sites(unsigned int part_num, std::vector<unsigned int>& site_part) const;
-  void compress_patterns(bool store_backmap = false);
+  void compress_patterns(bool store_backmap = false, unsigned int num_threads = 1);
   void set_model_empirical_params();
 
 private:
@@ -105,6 +110,7 @@ private:
   Model _model;
   MSA _msa;
   mutable PartitionStats _stats;
+  mutable double _repeats_ratio;     /* cached, reset whenever the MSA is replaced/compressed */
 };
 
 
@@ -1,4 +1,5 @@
 #include "PartitionedMSA.hpp"
+#include "util/threadutil.hpp"
 
 using namespace std;
 
@@ -11,6 +12,8 @@ PartitionedMSA& PartitionedMSA::operator=(PartitionedMSA&& other)
 {
   _part_list = std::move(other._part_list);
   _full_msa = std::move(other._full_msa);
+  _full_length = other._full_length;
+  _site_part_map = std::move(other._site_part_map);
   _taxon_names = std::move(other._taxon_names);
   _taxon_id_map = std::move(other._taxon_id_map);
    return *this;
@@ -36,7 +39,7 @@ void PartitionedMSA::set_taxon_names(const NameList& taxon_names)
 
 uintVector PartitionedMSA::get_site_part_assignment() const
 {
-  const size_t full_len = _full_msa.length();
+  const size_t full_len = _full_length;
 
   uintVector spa(full_len);
 
@@ -130,6 +133,7 @@ IdPairVector PartitionedMSA::full_to_parted_sitemap() const
 void PartitionedMSA::full_msa(MSA&& msa)
 {
   _full_msa = std::move(msa);
+  _full_length = _full_msa.length();
 
   set_taxon_names(_full_msa.labels());
 }
@@ -137,7 +141,7 @@ void PartitionedMSA::full_msa(MSA&& msa)
 void PartitionedMSA::split_msa()
 {
   bool need_split;
-  string full_range = "1-" + to_string(_full_msa.length());
+  string full_range = "1-" + to_string(_full_length);
 
   if (part_count() == 0)
     return;
@@ -152,34 +156,72 @@ void PartitionedMSA::split_msa()
 
   if (need_split)
   {
-    /* split MSA into partitions */
-    pll_msa_t ** part_msa_list =
-        pllmod_msa_split(_full_msa.pll_msa(), site_part_map().data(), part_count());
+    /* split MSA into partitions: sites are routed to their partitions one sequence at
+     * a time, and every full-length sequence is released right after it has been split.
+     * This way, the full alignment is never held in memory twice. */
+    if (_site_part_map.empty())
+      _site_part_map = get_site_part_assignment();
+
+    const auto& spa = _site_part_map;
+    assert(spa.size() == _full_length);
+
+    uintVector part_len(part_count(), 0);
+    for (auto p: spa)
+      part_len[p-1]++;
+
+    vector<MSA> part_msas;
+    part_msas.reserve(part_count());
+    for (size_t p = 0; p < part_count(); ++p)
+      part_msas.emplace_back(part_len[p]);
+
+    uintVector part_pos(part_count());
+    for (size_t i = 0; i < _full_msa.size(); ++i)
+    {
+      auto& full_seq = _full_msa[i];
+
+      vector<string> part_seqs(part_count());
+      for (size_t p = 0; p < part_count(); ++p)
+        part_seqs[p].resize(part_len[p]);
+
+      std::fill(part_pos.begin(), part_pos.end(), 0);
+      for (size_t j = 0; j < _full_length; ++j)
+      {
+        const auto p = spa[j] - 1;
+        part_seqs[p][part_pos[p]++] = full_seq[j];
+      }
+
+      string().swap(full_seq);
+
+      const auto& label = _full_msa.labels().empty() ? string() : _full_msa.label(i);
+      for (size_t p = 0; p < part_count(); ++p)
+        part_msas[p].append(std::move(part_seqs[p]), label);
+    }
 
     for (size_t p = 0; p < part_count(); ++p)
     {
-      part_msa(p, part_msa_list[p]);
-      pll_msa_destroy(part_msa_list[p]);
+      part_msa(p, std::move(part_msas[p]));
 
       /* distribute external site weights to per-partition MSAs */
       if (!_full_msa.weights().empty())
       {
         auto& msa = _part_list[p].msa();
         WeightVector w(msa.length());
-        const auto full_weights = _full_msa.weights();
-        assert(full_weights.size() == site_part_map().size());
+        const auto& full_weights = _full_msa.weights();
+        assert(full_weights.size() == spa.size());
 
         size_t pos = 0;
-        for (size_t i = 0; i < site_part_map().size(); ++i)
+        for (size_t i = 0; i < spa.size(); ++i)
         {
-          if (_site_part_map[i] == p+1)
+          if (spa[i] == p+1)
             w[pos++] = full_weights[i];
         }
         assert(pos == msa.length());
         msa.weights(w);
       }
     }
-    free(part_msa_list);
+
+    /* full alignment is not needed anymore */
+    _full_msa = MSA();
   }
   else
   {
@@ -189,11 +231,42 @@ void PartitionedMSA::split_msa()
   }
 }
 
-void PartitionedMSA::compress_patterns(bool store_backmap)
+void PartitionedMSA::pack_msa()
 {
   for (PartitionInfo& pinfo: _part_list)
   {
-    pinfo.compress_patterns(store_backmap);
+    /* stats are computed from pll_msa, which is not available after packing */
+    pinfo.stats();
+    pinfo.msa().pack();
+  }
+}
+
+size_t PartitionedMSA::seq_mem_size() const
+{
+  size_t mem_size = 0;
+  for (const auto& pinfo: _part_list)
+    mem_size += pinfo.msa().seq_mem_size();
+
+  return mem_size;
+}
+
+void PartitionedMSA::compress_patterns(bool store_backmap, unsigned int num_threads)
+{
+  if (part_count() >= num_threads)
+  {
+    /* many partitions: compress them concurrently (round-robin for better balance) */
+    parallel_blocks(num_threads, num_threads,
+                    [this, store_backmap, num_threads](size_t t, size_t, size_t)
+                    {
+                      for (size_t p = t; p < part_count(); p += num_threads)
+                        _part_list[p].compress_patterns(store_backmap, 1);
+                    });
+  }
+  else
+  {
+    /* few partitions: parallelize over alignment columns within every partition */
+    for (PartitionInfo& pinfo: _part_list)
+      pinfo.compress_patterns(store_backmap, num_threads);
   }
 }
 
@@ -14,7 +14,6 @@ public:
   PartitionedMSA& operator=(PartitionedMSA&& other);
 
   // getters
-  const MSA& full_msa() const { return (part_count() == 1) ? _part_list.at(0).msa() : _full_msa; };
   const MSA& part_msa(size_t index) const { return _part_list.at(index).msa(); };
   const PartitionInfo& part_info(size_t index) const { return _part_list.at(index); };
   const Model& model(size_t index) const { return _part_list.at(index).model(); };
@@ -59,12 +58,15 @@ public:
   }
 
   void split_msa();
-  void compress_patterns(bool store_backmap = false);
+  void compress_patterns(bool store_backmap = false, unsigned int num_threads = 1);
+  void pack_msa();
+  size_t seq_mem_size() const;
   void set_model_empirical_params();
 
 private:
   std::vector<PartitionInfo> _part_list;
-  MSA _full_msa;
+  MSA _full_msa;                /* released after split_msa() */
+  size_t _full_length = 0;
   NameList _taxon_names;
   NameIdMap _taxon_id_map;
   mutable uintVector _site_part_map;
@@ -217,11 +217,11 @@ string PartitionedMSAView::part_sequence(size_t taxon_id, size_t part_id, bool u
   if (unweighted(part_id) || !uncompress)
   {
     if (_excluded_sites.empty() || _excluded_sites[part_id].empty())
-      return msa.at(orig_id);
+      return msa.sequence(orig_id);
     else
     {
       auto part_len = part_length(part_id);
-      auto orig_seq = msa.at(orig_id);
+      auto orig_seq = msa.sequence(orig_id);
       string seq;
       seq.reserve(part_len);
       auto pos = 0;
@@ -245,7 +245,7 @@ string PartitionedMSAView::part_sequence(size_t taxon_id, size_t part_id, bool u
     const auto& w = _site_weights.empty() ? msa.weights() : _site_weights.at(part_id);
     auto qignore = get_exclude_queue(part_id);
 
-    auto orig_seq = msa.at(orig_id);
+    auto orig_seq = msa.sequence(orig_id);
     string seq;
     auto uncomp_len = part_sites(part_id);
     seq.reserve(uncomp_len);
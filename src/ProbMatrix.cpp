@@ -0,0 +1,132 @@
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "ProbMatrix.hpp"
+
+using namespace std;
+
+/* cache line alignment, sufficient for any SIMD loads on the buffer */
+static const size_t PROB_MATRIX_ALIGNMENT = 64;
+
+ProbMatrix::ProbMatrix(ProbMatrix&& other) : _data(other._data), _taxa(other._taxa),
+    _sites(other._sites), _states(other._states), _single(other._single)
+{
+  other._data = nullptr;
+  other._taxa = other._sites = other._states = 0;
+}
+
+ProbMatrix::~ProbMatrix()
+{
+  clear();
+}
+
+ProbMatrix& ProbMatrix::operator=(ProbMatrix&& other)
+{
+  if (this != &other)
+  {
+    clear();
+
+    _data = other._data;
+    _taxa = other._taxa;
+    _sites = other._sites;
+    _states = other._states;
+    _single = other._single;
+
+    other._data = nullptr;
+    other._taxa = other._sites = other._states = 0;
+  }
+  return *this;
+}
+
+void ProbMatrix::resize(size_t taxa, size_t sites, size_t states, bool single_precision)
+{
+  clear();
+
+  _taxa = taxa;
+  _sites = sites;
+  _states = states;
+  _single = single_precision;
+
+  const auto size = mem_size();
+  if (size > 0)
+  {
+    void * buf = nullptr;
+    if (posix_memalign(&buf, PROB_MATRIX_ALIGNMENT, size) || !buf)
+    {
+      _taxa = _sites = _states = 0;
+      throw bad_alloc();
+    }
+    memset(buf, 0, size);
+    _data = (char *) buf;
+  }
+}
+
+void ProbMatrix::clear()
+{
+  free(_data);
+  _data = nullptr;
+  _taxa = _sites = _states = 0;
+}
+
+bool ProbMatrix::site_equal(size_t taxon, size_t site1, size_t site2) const
+{
+  return memcmp(site_ptr(taxon, site1), site_ptr(taxon, site2), _states * value_size()) == 0;
+}
+
+int ProbMatrix::site_compare(size_t taxon, size_t site1, size_t site2) const
+{
+  for (size_t k = 0; k < _states; ++k)
+  {
+    const auto a = get(taxon, site1, k);
+    const auto b = get(taxon, site2, k);
+    if (a != b)
+      return a < b ? -1 : 1;
+  }
+  return 0;
+}
+
+uint64_t ProbMatrix::site_hash(size_t taxon, size_t site, uint64_t hash) const
+{
+  /* FNV-1a over the raw bytes */
+  auto p = (const unsigned char *) site_ptr(taxon, site);
+  const auto p_end = p + _states * value_size();
+  for (; p < p_end; ++p)
+    hash = (hash ^ *p) * 1099511628211ULL;
+  return hash;
+}
+
+void ProbMatrix::copy_site(size_t taxon, size_t site, const ProbMatrix& src, size_t src_site)
+{
+  assert(src._states == _states && src._single == _single);
+  memcpy(_data + offset(taxon, site) * value_size(), src.site_ptr(taxon, src_site),
+         _states * value_size());
+}
+
+bool ProbMatrix::normalized() const
+{
+  const size_t count = _taxa * _sites * _states;
+  for (size_t i = 0; i < count; ++i)
+  {
+    const double p = _single ? (double) ((const float *) _data)[i] : ((const double *) _data)[i];
+    if (p > 1.)
+      return false;
+  }
+
+  return true;
+}
+
+std::vector<double> ProbMatrix::state_sums(const std::vector<unsigned int>& site_weights) const
+{
+  assert(site_weights.empty() || site_weights.size() == _sites);
+
+  std::vector<double> sums(_states, 0.);
+  const size_t count = _taxa * _sites * _states;
+  for (size_t i = 0; i < count; ++i)
+  {
+    const double v = _single ? (double) ((const float *) _data)[i] : ((const double *) _data)[i];
+    sums[i % _states] += site_weights.empty() ? v : v * site_weights[(i / _states) % _sites];
+  }
+
+  return sums;
+}
@@ -0,0 +1,90 @@
+#ifndef RAXML_PROBMATRIX_HPP_
+#define RAXML_PROBMATRIX_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cassert>
+#include <vector>
+
+/* State probabilities of a probabilistic alignment (e.g. CATG) for all taxa, stored in
+ * a single aligned buffer ordered taxon -> site -> state. Values are kept either in double
+ * or in single precision, the latter halves the memory footprint. */
+class ProbMatrix
+{
+public:
+  ProbMatrix() : _data(nullptr), _taxa(0), _sites(0), _states(0), _single(false) {}
+  ProbMatrix(ProbMatrix&& other);
+  ProbMatrix(const ProbMatrix& other) = delete;
+  ~ProbMatrix();
+
+  ProbMatrix& operator=(ProbMatrix&& other);
+  ProbMatrix& operator=(const ProbMatrix& other) = delete;
+
+  /* (re)allocate the buffer, all probabilities are set to 0 */
+  void resize(size_t taxa, size_t sites, size_t states, bool single_precision);
+  void clear();
+
+  bool empty() const { return _data == nullptr; }
+  size_t taxa() const { return _taxa; }
+  size_t sites() const { return _sites; }
+  size_t states() const { return _states; }
+  bool single_precision() const { return _single; }
+  size_t value_size() const { return _single ? sizeof(float) : sizeof(double); }
+  size_t mem_size() const { return _taxa * _sites * _states * value_size(); }
+
+  double get(size_t taxon, size_t site, size_t state) const
+  {
+    const auto pos = offset(taxon, site) + state;
+    return _single ? (double) ((const float *) _data)[pos] : ((const double *) _data)[pos];
+  }
+
+  void set(size_t taxon, size_t site, size_t state, double value)
+  {
+    const auto pos = offset(taxon, site) + state;
+    if (_single)
+      ((float *) _data)[pos] = (float) value;
+    else
+      ((double *) _data)[pos] = value;
+  }
+
+  /* raw access to the state probabilities of a site, T must match the storage precision */
+  template<typename T>
+  const T * data(size_t taxon, size_t site) const
+  {
+    assert(sizeof(T) == value_size());
+    return ((const T *) _data) + offset(taxon, site);
+  }
+
+  /* byte-wise site comparison and hashing (used for pattern compression) */
+  bool site_equal(size_t taxon, size_t site1, size_t site2) const;
+  int site_compare(size_t taxon, size_t site1, size_t site2) const;
+  uint64_t site_hash(size_t taxon, size_t site, uint64_t hash) const;
+
+  void copy_site(size_t taxon, size_t site, const ProbMatrix& src, size_t src_site);
+
+  /* true if all values are <= 1 */
+  bool normalized() const;
+
+  /* sum of the probabilities per state over all taxa and sites; if site_weights are given,
+   * every site contributes with its weight (e.g. pattern counts after compression) */
+  std::vector<double> state_sums(const std::vector<unsigned int>& site_weights =
+                                   std::vector<unsigned int>()) const;
+
+private:
+  char * _data;
+  size_t _taxa;
+  size_t _sites;
+  size_t _states;
+  bool _single;
+
+  size_t offset(size_t taxon, size_t site) const
+  {
+    assert(taxon < _taxa && site < _sites);
+    return (taxon * _sites + site) * _states;
+  }
+
+  const char * site_ptr(size_t taxon, size_t site) const
+  { return _data + offset(taxon, site) * value_size(); }
+};
+
+#endif /* RAXML_PROBMATRIX_HPP_ */
@@ -0,0 +1,110 @@
+#include <fstream>
+
+#include "SearchTrace.hpp"
+
+using namespace std;
+
+/* one trace file per MPI rank, shared by all local workers */
+static ofstream trace_stream;
+
+void SearchTrace::open(const std::string& fname, bool append)
+{
+  ParallelContext::UniqueLock lock;
+
+  if (trace_stream.is_open())
+    trace_stream.close();
+
+  trace_stream.open(fname, append ? ios::out | ios::app : ios::out | ios::trunc);
+  if (!trace_stream)
+    throw runtime_error("Unable to open search trace file for writing: " + fname);
+}
+
+void SearchTrace::close()
+{
+  ParallelContext::UniqueLock lock;
+
+  if (trace_stream.is_open())
+    trace_stream.close();
+}
+
+bool SearchTrace::enabled()
+{
+  return trace_stream.is_open();
+}
+
+const char * SearchTrace::step_name(CheckpointStep step)
+{
+  switch (step)
+  {
+    case CheckpointStep::start:
+      return "start";
+    case CheckpointStep::brlenOpt:
+      return "brlenOpt";
+    case CheckpointStep::modOpt1:
+      return "modOpt1";
+    case CheckpointStep::radiusDetect:
+      return "radiusDetect";
+    case CheckpointStep::modOpt2:
+      return "modOpt2";
+    case CheckpointStep::fastSPR:
+      return "fastSPR";
+    case CheckpointStep::modOpt3:
+      return "modOpt3";
+    case CheckpointStep::slowSPR:
+      return "slowSPR";
+    case CheckpointStep::modOpt4:
+      return "modOpt4";
+    case CheckpointStep::finish:
+      return "finish";
+    default:
+      assert(0);
+      return "unknown";
+  }
+}
+
+void SearchTrace::start(double loglh)
+{
+  if (!_active)
+    return;
+
+  _wall_start = global_timer().elapsed_seconds();
+  _cpu_start = sysutil_get_thread_cputime();
+  _reductions_start = ParallelContext::num_reductions();
+  _loglh_start = loglh;
+}
+
+void SearchTrace::record(CheckpointStep step, size_t tree_index, int iter, int radius,
+                         double loglh, long moves)
+{
+  if (!_active || !ParallelContext::group_master_thread())
+    return;
+
+  const double wall_end = global_timer().elapsed_seconds();
+  const double cpu_end = sysutil_get_thread_cputime();
+
+  ostringstream ss;
+  ss << "{\"worker\": " << ParallelContext::group_id() <<
+        ", \"rank\": " << ParallelContext::rank_id() <<
+        ", \"tree\": " << tree_index <<
+        ", \"step\": \"" << step_name(step) << "\"" <<
+        ", \"round\": " << iter <<
+        ", \"radius\": " << radius <<
+        fixed << setprecision(6) <<
+        ", \"wall_start\": " << _wall_start <<
+        ", \"wall_time\": " << wall_end - _wall_start <<
+        ", \"cpu_time\": " << cpu_end - _cpu_start <<
+        ", \"loglh_before\": " << _loglh_start <<
+        ", \"loglh_after\": " << loglh <<
+        ", \"moves\": ";
+  if (moves >= 0)
+    ss << moves;
+  else
+    ss << "null";
+  ss << ", \"reductions\": " << ParallelContext::num_reductions() - _reductions_start << "}" << endl;
+
+  {
+    ParallelContext::UniqueLock lock;
+    trace_stream << ss.str();
+    trace_stream.flush();
+  }
+}
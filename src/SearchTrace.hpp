@@ -0,0 +1,36 @@
+#ifndef RAXML_SEARCHTRACE_HPP_
+#define RAXML_SEARCHTRACE_HPP_
+
+#include "Checkpoint.hpp"
+
+/* Machine-readable trace of the tree search (one JSON record per line): one record is written
+ * for every search step and every SPR round. The trace file is shared by all workers
+ * of an MPI rank, records are only written by the group master thread of every worker. */
+class SearchTrace
+{
+public:
+  SearchTrace() : _active(false), _wall_start(0.), _cpu_start(0.), _reductions_start(0),
+                  _loglh_start(0.) {}
+
+  static void open(const std::string& fname, bool append);
+  static void close();
+  static bool enabled();
+
+  void enable(bool active) { _active = active && enabled(); }
+  bool active() const { return _active; }
+
+  void start(double loglh);
+  void record(CheckpointStep step, size_t tree_index, int iter, int radius, double loglh,
+              long moves = -1);
+
+  static const char * step_name(CheckpointStep step);
+
+private:
+  bool _active;
+  double _wall_start;
+  double _cpu_start;
+  size_t _reductions_start;
+  double _loglh_start;
+};
+
+#endif /* RAXML_SEARCHTRACE_HPP_ */
@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <random>
 
 #include "Tree.hpp"
 #include "io/file_io.hpp"
@@ -242,6 +243,65 @@ Tree Tree::buildParsimonyConstrained(const ParsimonyMSA& pars_msa, unsigned int
   return tree;
 }
 
+/* Collapse-and-resolve improvement of a parsimony tree: collapse a random subset of inner
+ * branches, and re-resolve the resulting polytomies with buildParsimonyConstrained() (i.e.
+ * randomized stepwise addition in libpll-modules, using the collapsed tree as a constraint).
+ * The new tree is accepted if its score is not worse than the current one (to allow moving
+ * across score plateaus). NB: site weights are NOT perturbed. Stops after max_iters iterations
+ * or max_seconds (if > 0), whichever comes first; the latter makes the result depend on machine
+ * speed/load. */
+Tree Tree::improveParsimony(const ParsimonyMSA& pars_msa, const Tree& tree,
+                            unsigned int random_seed, unsigned int * score,
+                            unsigned int max_iters, double max_seconds)
+{
+  assert(score);
+
+  Tree best_tree = tree;
+  unsigned int best_score = *score;
+
+  std::mt19937 gen(random_seed);
+  std::uniform_real_distribution<double> distr(0., 1.);
+
+  const double start_time = sysutil_gettime();
+  for (unsigned int i = 0; i < max_iters; ++i)
+  {
+    if (max_seconds > 0. && sysutil_gettime() - start_time > max_seconds)
+      break;
+
+    Tree cons_tree = best_tree;
+    size_t collapsed = 0;
+    for (auto node: cons_tree.subnodes())
+    {
+      /* visit every branch only once */
+      if (node->node_index > node->back->node_index)
+        continue;
+
+      bool collapse = node->next && node->back->next &&
+                      distr(gen) < RAXML_PARS_COLLAPSE_FRACTION;
+      node->length = node->back->length = collapse ? 0. : RAXML_BRLEN_DEFAULT;
+      collapsed += collapse ? 1 : 0;
+    }
+
+    if (!collapsed)
+      continue;
+
+    cons_tree.collapse_short_branches(RAXML_BRLEN_MIN);
+
+    unsigned int new_score;
+    auto new_tree = buildParsimonyConstrained(pars_msa, gen(), &new_score, cons_tree, IDVector());
+
+    if (new_score <= best_score)
+    {
+      best_tree = std::move(new_tree);
+      best_score = new_score;
+    }
+  }
+
+  *score = best_score;
+
+  return best_tree;
+}
+
 Tree Tree::loadFromFile(const std::string& file_name)
 {
   Tree tree;
@@ -409,30 +469,30 @@ void Tree::collapse_short_branches(double min_brlen)
     libpll_check_error("Failed to collapse short branches: ", true);
 }
 
-PllNodeVector Tree::subnodes() const
+static PllNodeVector utree_subnodes(const pll_utree_t& pll_utree)
 {
-  PllNodeVector subnodes;
+  PllNodeVector subnodes(2 * pll_utree.edge_count, nullptr);
 
-  if (_num_tips > 0)
+  for (size_t i = 0; i < pll_utree.tip_count + pll_utree.inner_count; ++i)
   {
-    subnodes.resize(num_subnodes());
-
-    for (size_t i = 0; i < _pll_utree->tip_count + _pll_utree->inner_count; ++i)
+    auto start = pll_utree.nodes[i];
+    auto node = start;
+    do
     {
-      auto start = _pll_utree->nodes[i];
-      auto node = start;
-      do
-      {
-        subnodes[node->node_index] = node;
-        node = node->next;
-      }
-      while (node && node != start);
+      subnodes[node->node_index] = node;
+      node = node->next;
     }
+    while (node && node != start);
   }
 
   return subnodes;
 }
 
+PllNodeVector Tree::subnodes() const
+{
+  return _num_tips > 0 ? utree_subnodes(*_pll_utree) : PllNodeVector();
+}
+
 TreeTopology Tree::topology() const
 {
   TreeTopology topol;
@@ -467,10 +527,20 @@ TreeTopology Tree::topology() const
 
 void Tree::topology(const TreeTopology& topol)
 {
-  if (topol.edges.size() != num_branches())
+  if (!_pll_utree)
     throw runtime_error("Incompatible topology!");
 
-  auto allnodes = subnodes();
+  apply_topology(*_pll_utree, topol);
+
+  _partition_brlens = topol.brlens;
+}
+
+void Tree::apply_topology(pll_utree_t& pll_utree, const TreeTopology& topol)
+{
+  if (topol.edges.size() != pll_utree.edge_count)
+    throw runtime_error("Incompatible topology!");
+
+  auto allnodes = utree_subnodes(pll_utree);
   unsigned int pmatrix_index = 0;
   for (const auto& branch: topol)
   {
@@ -486,11 +556,9 @@ void Tree::topology(const TreeTopology& topol)
 //           branch.length, left_node->pmatrix_index, left_node->clv_index, right_node->clv_index);
   }
 
-  _pll_utree->vroot = allnodes[topol.vroot_node_id];
-
-  _partition_brlens = topol.brlens;
+  pll_utree.vroot = allnodes[topol.vroot_node_id];
 
-  assert(pmatrix_index == num_branches());
+  assert(pmatrix_index == pll_utree.edge_count);
 }
 
 const doubleVector& Tree::partition_brlens(size_t partition_idx) const
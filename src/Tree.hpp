@@ -96,6 +96,9 @@ public:
   static Tree buildParsimonyConstrained(const ParsimonyMSA& parted_msa, unsigned int random_seed,
                              unsigned int * score, const Tree& constrained_tree,
                              const IDVector& tip_msa_idmap);
+  static Tree improveParsimony(const ParsimonyMSA& pars_msa, const Tree& tree,
+                               unsigned int random_seed, unsigned int * score,
+                               unsigned int max_iters, double max_seconds = 0.);
   static Tree loadFromFile(const std::string& file_name);
 
   std::vector<const char*> tip_labels_cstr() const;
@@ -105,6 +108,8 @@ public:
 
   TreeTopology topology() const;
   void topology(const TreeTopology& topol);
+  /* change topology and branch lengths of a pll_utree in-place (structure must be compatible) */
+  static void apply_topology(pll_utree_t& pll_utree, const TreeTopology& topol);
 
   const std::vector<doubleVector>& partition_brlens() const { return _partition_brlens; }
   const doubleVector& partition_brlens(size_t partition_idx) const;
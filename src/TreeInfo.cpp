@@ -1,4 +1,6 @@
 #include <algorithm>
+#include <random>
+#include <tuple>
 
 #include "TreeInfo.hpp"
 #include "ParallelContext.hpp"
@@ -31,6 +33,12 @@ void TreeInfo::init(const Options &opts, const Tree& tree, const PartitionedMSA&
   _check_lh_impr = opts.safety_checks.isset(SafetyCheck::model_lh_impr);
   _use_old_constraint = opts.use_old_constraint;
   _use_spr_fastclv = opts.use_spr_fastclv;
+  _use_spr_taxpar = opts.use_spr_taxpar;
+  _use_local_modopt = opts.use_local_modopt;
+  _use_spr_cache = opts.use_spr_cache && opts.use_spr_taxpar;
+  _spr_cache_epoch = 0;
+  _spr_cache_hits = _spr_cache_misses = 0;
+  _spr_moves = -1;
 
   _partition_contributions.resize(parted_msa.part_count());
   double total_weight = 0;
@@ -42,8 +50,9 @@ void TreeInfo::init(const Options &opts, const Tree& tree, const PartitionedMSA&
   libpll_check_error("ERROR creating treeinfo structure");
   assert(_pll_treeinfo);
 
+  /* in taxon-parallel mode, every thread holds all sites -> no reduction needed */
   pllmod_treeinfo_set_parallel_context(_pll_treeinfo, (void *) nullptr,
-                                       ParallelContext::parallel_reduce_cb);
+                                       _use_spr_taxpar ? nullptr : ParallelContext::parallel_reduce_cb);
 
   // init partitions
   int optimize_branches = opts.optimize_brlen ? PLLMOD_OPT_PARAM_BRANCHES_ITERATIVE : 0;
@@ -182,6 +191,19 @@ Tree TreeInfo::tree(size_t partition_id) const
 void TreeInfo::tree(const Tree& tree)
 {
   _pll_treeinfo->root = pll_utree_graph_clone(&tree.pll_utree_root());
+  _spr_cache.clear();
+}
+
+void TreeInfo::topology(const TreeTopology& topol)
+{
+  auto tree = _pll_treeinfo->tree;
+
+  Tree::apply_topology(*tree, topol);
+
+  pllmod_treeinfo_set_root(_pll_treeinfo, tree->vroot);
+  pllmod_treeinfo_invalidate_all(_pll_treeinfo);
+
+  _spr_cache.clear();
 }
 
 double TreeInfo::loglh(bool incremental)
@@ -209,6 +231,8 @@ void TreeInfo::model(size_t partition_id, const Model& model)
   _pll_treeinfo->alphas[partition_id] = model.alpha();
   if (_pll_treeinfo->brlen_scalers)
     _pll_treeinfo->brlen_scalers[partition_id] = model.brlen_scaler();
+
+  _spr_cache_epoch++;
 }
 
 //#define DBG printf
@@ -217,6 +241,7 @@ double TreeInfo::optimize_branches(double lh_epsilon, double brlen_smooth_factor
 {
   /* update all CLVs and p-matrices before calling BLO */
   double new_loglh = loglh();
+  const double old_loglh = new_loglh;
 
   if (_pll_treeinfo->params_to_optimize[0] & PLLMOD_OPT_PARAM_BRANCHES_ITERATIVE)
   {
@@ -253,10 +278,98 @@ double TreeInfo::optimize_branches(double lh_epsilon, double brlen_smooth_factor
     assert(isfinite(new_loglh));
   }
 
+  /* likelihood landscape has changed -> SPR gains cached so far are not reliable anymore */
+  if (fabs(new_loglh - old_loglh) > RAXML_SPR_CACHE_BRLEN_EPS)
+    _spr_cache_epoch++;
+
   return new_loglh;
 }
 
+/* model parameters which can be optimized independently for every partition */
+static const int LOCAL_MODOPT_PARAMS = PLLMOD_OPT_PARAM_SUBST_RATES | PLLMOD_OPT_PARAM_FREQUENCIES |
+                                       PLLMOD_OPT_PARAM_ALPHA | PLLMOD_OPT_PARAM_PINV;
+
 double TreeInfo::optimize_params(int params_to_optimize, double lh_epsilon)
+{
+  /* model parameters affect all sites -> invalidate SPR move cache */
+  _spr_cache_epoch++;
+
+  if (_use_local_modopt && (params_to_optimize & LOCAL_MODOPT_PARAMS))
+    return optimize_params_local(params_to_optimize, lh_epsilon);
+  else
+    return optimize_params_impl(params_to_optimize, lh_epsilon);
+}
+
+void TreeInfo::init_parts_local()
+{
+  const auto part_count = _pll_treeinfo->partition_count;
+
+  /* count threads which hold (a slice of) every partition */
+  doubleVector part_threads(part_count, 0.);
+  for (unsigned int p = 0; p < part_count; ++p)
+    part_threads[p] = _pll_treeinfo->partitions[p] ? 1. : 0.;
+
+  ParallelContext::parallel_reduce(part_threads.data(), part_count, PLLMOD_COMMON_REDUCE_SUM);
+
+  _parts_local.resize(part_count);
+  for (unsigned int p = 0; p < part_count; ++p)
+    _parts_local[p] = (part_threads[p] < 1.5);
+
+  LOG_DEBUG << "Partitions eligible for thread-local model optimization: "
+            << std::count(_parts_local.begin(), _parts_local.end(), true) << " / "
+            << part_count << endl;
+}
+
+/* Partitions which are not split between threads are optimized in two steps:
+ * 1) independent per-partition parameters (rates, freqs, alpha, pinv) are optimized
+ *    by the owner thread, without any reductions
+ * 2) remaining parameters are optimized jointly as usual
+ * Partitions split between threads are optimized jointly in step 2. */
+double TreeInfo::optimize_params_local(int params_to_optimize, double lh_epsilon)
+{
+  if (_parts_local.empty())
+    init_parts_local();
+
+  const auto part_count = _pll_treeinfo->partition_count;
+  std::vector<int> orig_params(_pll_treeinfo->params_to_optimize,
+                               _pll_treeinfo->params_to_optimize + part_count);
+
+  double cur_loglh = loglh();
+
+  /* step 1: thread-local optimization */
+  for (unsigned int p = 0; p < part_count; ++p)
+  {
+    _pll_treeinfo->params_to_optimize[p] = _parts_local[p] && _pll_treeinfo->partitions[p] ?
+                                           orig_params[p] & LOCAL_MODOPT_PARAMS : 0;
+  }
+
+  bool check_lh_impr = _check_lh_impr;
+  _check_lh_impr = false;
+  pllmod_treeinfo_set_parallel_context(_pll_treeinfo, (void *) nullptr, nullptr);
+
+  optimize_params_impl(params_to_optimize & LOCAL_MODOPT_PARAMS, lh_epsilon);
+
+  pllmod_treeinfo_set_parallel_context(_pll_treeinfo, (void *) nullptr,
+                                       _use_spr_taxpar ? nullptr : ParallelContext::parallel_reduce_cb);
+  _check_lh_impr = check_lh_impr;
+
+  /* step 2: joint optimization of shared partitions and remaining parameters */
+  for (unsigned int p = 0; p < part_count; ++p)
+  {
+    _pll_treeinfo->params_to_optimize[p] = _parts_local[p] ?
+                                           orig_params[p] & ~LOCAL_MODOPT_PARAMS : orig_params[p];
+  }
+
+  double new_loglh = optimize_params_impl(params_to_optimize, lh_epsilon);
+
+  std::copy(orig_params.cbegin(), orig_params.cend(), _pll_treeinfo->params_to_optimize);
+
+  assert_lh_improvement(cur_loglh, new_loglh, "LOCAL MODOPT");
+
+  return new_loglh;
+}
+
+double TreeInfo::optimize_params_impl(int params_to_optimize, double lh_epsilon)
 {
   assert(!pll_errno);
 
@@ -385,6 +498,12 @@ double TreeInfo::optimize_params(int params_to_optimize, double lh_epsilon)
 
 double TreeInfo::spr_round(spr_round_params& params)
 {
+  if (_use_spr_taxpar)
+    return spr_round_taxpar(params);
+
+  /* libpll does not report the number of applied moves */
+  _spr_moves = -1;
+
   double loglh = pllmod_algo_spr_round(_pll_treeinfo, params.radius_min, params.radius_max,
                                params.ntopol_keep, params.thorough, _brlen_opt_method,
                                _brlen_min, _brlen_max, RAXML_BRLEN_SMOOTHINGS,
@@ -401,6 +520,425 @@ double TreeInfo::spr_round(spr_round_params& params)
   return loglh;
 }
 
+/* collect regraft edges at distance [radius_min, radius_max] from the pruning point, along with
+ * the inner nodes on the path to each of them (their CLVs will change when subtree is moved) */
+static void spr_collect_regraft_edges(pll_unode_t * node, int depth, int radius_min, int radius_max,
+                                      PllNodeVector& path, PllNodeVector& edges,
+                                      std::vector<PllNodeVector>& paths)
+{
+  if (depth >= radius_min)
+  {
+    edges.push_back(node);
+    paths.push_back(path);
+  }
+
+  if (depth < radius_max && node->back->next)
+  {
+    path.push_back(node->back);
+    spr_collect_regraft_edges(node->back->next, depth+1, radius_min, radius_max, path, edges, paths);
+    spr_collect_regraft_edges(node->back->next->next, depth+1, radius_min, radius_max, path, edges, paths);
+    path.pop_back();
+  }
+}
+
+static void spr_collect_regraft_edges(pll_unode_t * p_edge, int radius_min, int radius_max,
+                                      PllNodeVector& edges, std::vector<PllNodeVector>& paths)
+{
+  edges.clear();
+  paths.clear();
+
+  for (auto start: {p_edge->next->back, p_edge->next->next->back})
+  {
+    if (!start->next)
+      continue;
+
+    PllNodeVector path(1, start);
+    spr_collect_regraft_edges(start->next, 1, radius_min, radius_max, path, edges, paths);
+    spr_collect_regraft_edges(start->next->next, 1, radius_min, radius_max, path, edges, paths);
+  }
+}
+
+static void spr_invalidate(pllmod_treeinfo_t * treeinfo, pll_unode_t * p_edge,
+                           pll_unode_t * r_edge, const PllNodeVector& path)
+{
+  for (auto node: {p_edge, p_edge->next, p_edge->next->next, r_edge, r_edge->back})
+  {
+    pllmod_treeinfo_invalidate_clv(treeinfo, node);
+    pllmod_treeinfo_invalidate_pmatrix(treeinfo, node);
+  }
+
+  for (auto node: path)
+  {
+    pllmod_treeinfo_invalidate_clv(treeinfo, node);
+    pllmod_treeinfo_invalidate_clv(treeinfo, node->next);
+    pllmod_treeinfo_invalidate_clv(treeinfo, node->next->next);
+    pllmod_treeinfo_invalidate_pmatrix(treeinfo, node);
+  }
+}
+
+static inline void hash_combine(uint64_t& h, uint64_t v)
+{
+  h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+}
+
+/* fingerprint of the neighborhood of a pruning point: adjacent nodes, all regraft edges within
+ * the radius and their version stamps (bumped every time a committed move touches a node),
+ * plus the global epoch (bumped by model parameter and branch length optimization) */
+uint64_t TreeInfo::spr_region_stamp(pll_unode_t * p_edge, const PllNodeVector& regraft_edges,
+                                    const spr_round_params& params) const
+{
+  uint64_t h = 0;
+  hash_combine(h, _spr_cache_epoch);
+  hash_combine(h, params.thorough);
+  hash_combine(h, params.radius_min);
+  hash_combine(h, params.radius_max);
+
+  for (auto node: {p_edge, p_edge->next, p_edge->next->next})
+  {
+    hash_combine(h, node->back->node_index);
+    hash_combine(h, _node_versions[node->node_index]);
+  }
+
+  for (auto r_edge: regraft_edges)
+  {
+    hash_combine(h, r_edge->node_index);
+    hash_combine(h, r_edge->back->node_index);
+    hash_combine(h, _node_versions[r_edge->node_index]);
+    hash_combine(h, _node_versions[r_edge->back->node_index]);
+  }
+
+  return h;
+}
+
+/* split hashes: hashes[node_index] identifies the set of taxa in the subtree behind node->back,
+ * i.e. it does not depend on node indices, which are reshuffled by SPR moves */
+void TreeInfo::spr_subtree_hashes(const PllNodeVector& node_map, std::vector<uint64_t>& hashes) const
+{
+  hashes.assign(node_map.size(), 0);
+  std::vector<bool> done(node_map.size(), false);
+
+  /* iterative post-order: hash of node = hash of its back subtree */
+  PllNodeVector stack;
+  for (auto start: node_map)
+  {
+    stack.push_back(start);
+    while (!stack.empty())
+    {
+      auto node = stack.back();
+      if (done[node->node_index])
+      {
+        stack.pop_back();
+        continue;
+      }
+
+      const auto back = node->back;
+      uint64_t h;
+      if (!back->next)
+      {
+        /* splitmix64 of the tip index */
+        h = back->clv_index + 0x9e3779b97f4a7c15ULL;
+        h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+        h ^= h >> 31;
+      }
+      else if (done[back->next->node_index] && done[back->next->next->node_index])
+        h = hashes[back->next->node_index] ^ hashes[back->next->next->node_index];
+      else
+      {
+        stack.push_back(back->next);
+        stack.push_back(back->next->next);
+        continue;
+      }
+
+      hashes[node->node_index] = h;
+      done[node->node_index] = true;
+      stack.pop_back();
+    }
+  }
+}
+
+void TreeInfo::spr_touch_node(const pll_unode_t * node)
+{
+  _node_versions[node->node_index]++;
+  if (node->next)
+  {
+    _node_versions[node->next->node_index]++;
+    _node_versions[node->next->next->node_index]++;
+  }
+}
+
+/* Taxon-parallel SPR round: every thread holds all alignment sites and evaluates a subset
+ * of pruning points locally (without reductions). Candidate moves are scored lazily, i.e.
+ * without branch length optimization. Best candidates from all threads are then exchanged,
+ * and committed in the same order on every thread to keep the trees in sync. */
+double TreeInfo::spr_round_taxpar(spr_round_params& params)
+{
+  const size_t num_threads = ParallelContext::threads_per_group();
+  const size_t thread_id = ParallelContext::local_proc_id();
+  const size_t max_moves = RAXML_SPR_TAXPAR_MOVES;
+  const double lh_epsilon = RAXML_LOGLH_TOLERANCE;
+
+  auto treeinfo = _pll_treeinfo;
+  auto tree = treeinfo->tree;
+
+  pllmod_treeinfo_invalidate_all(treeinfo);
+  double best_loglh = loglh();
+
+  /* node_index -> node map, subnodes of inner nodes are pruning candidates */
+  PllNodeVector node_map(tree->tip_count + 3 * tree->inner_count, nullptr);
+  PllNodeVector prune_edges;
+  for (unsigned int i = 0; i < tree->tip_count + tree->inner_count; ++i)
+  {
+    auto node = tree->nodes[i];
+    node_map.at(node->node_index) = node;
+    if (node->next)
+    {
+      for (auto sub: {node, node->next, node->next->next})
+      {
+        node_map.at(sub->node_index) = sub;
+        prune_edges.push_back(sub);
+      }
+    }
+  }
+
+  if (_node_versions.size() != node_map.size())
+    _node_versions.assign(node_map.size(), 0);
+
+  std::vector<uint64_t> split_hashes;
+  if (_use_spr_cache)
+    spr_subtree_hashes(node_map, split_hashes);
+
+  /* evaluate local share of pruning points */
+  typedef std::tuple<double, size_t, size_t> SPRMove;
+  std::vector<SPRMove> local_moves;
+  PllNodeVector regraft_edges;
+  std::vector<PllNodeVector> paths;
+  pll_tree_rollback_t rollback;
+  for (size_t i = thread_id; i < prune_edges.size(); i += num_threads)
+  {
+    auto p_edge = prune_edges[i];
+
+    spr_collect_regraft_edges(p_edge, params.radius_min, params.radius_max, regraft_edges, paths);
+
+    uint64_t region_stamp = 0;
+    if (_use_spr_cache)
+    {
+      region_stamp = spr_region_stamp(p_edge, regraft_edges, params);
+      auto entry = _spr_cache.find(split_hashes[p_edge->node_index]);
+      if (entry != _spr_cache.end() && entry->second.region_stamp == region_stamp &&
+          entry->second.lh_gain <= lh_epsilon)
+      {
+        _spr_cache_hits++;
+        continue;
+      }
+      _spr_cache_misses++;
+    }
+
+    SPRMove best_move(best_loglh + lh_epsilon, 0, 0);
+    double best_move_loglh = -INFINITY;
+    bool found = false;
+    for (size_t j = 0; j < regraft_edges.size(); ++j)
+    {
+      auto r_edge = regraft_edges[j];
+
+      if (!pllmod_utree_spr(p_edge, r_edge, &rollback))
+      {
+        libpll_reset_error();
+        continue;
+      }
+
+      spr_invalidate(treeinfo, p_edge, r_edge, paths[j]);
+      pllmod_treeinfo_set_root(treeinfo, p_edge);
+      double move_loglh = loglh(true);
+
+      pllmod_tree_rollback(&rollback);
+      spr_invalidate(treeinfo, p_edge, r_edge, paths[j]);
+
+      best_move_loglh = std::max(best_move_loglh, move_loglh);
+
+      if (move_loglh > std::get<0>(best_move))
+      {
+        best_move = SPRMove(move_loglh, p_edge->node_index, r_edge->node_index);
+        found = true;
+      }
+    }
+
+    if (_use_spr_cache)
+      _spr_cache[split_hashes[p_edge->node_index]] = {region_stamp, best_move_loglh - best_loglh};
+
+    if (found)
+      local_moves.push_back(best_move);
+  }
+
+  std::sort(local_moves.begin(), local_moves.end(),
+            [](const SPRMove& a, const SPRMove& b) { return std::get<0>(a) > std::get<0>(b); });
+  if (local_moves.size() > max_moves)
+    local_moves.resize(max_moves);
+
+  /* exchange best moves: every thread fills its own slots, empty slots are set to 0 */
+  doubleVector move_buf(num_threads * max_moves * 3, 0.);
+  for (size_t j = 0; j < local_moves.size(); ++j)
+  {
+    auto buf = move_buf.begin() + (thread_id * max_moves + j) * 3;
+    buf[0] = std::get<0>(local_moves[j]);
+    buf[1] = std::get<1>(local_moves[j]);
+    buf[2] = std::get<2>(local_moves[j]);
+  }
+
+  if (num_threads > 1)
+    ParallelContext::parallel_reduce(move_buf.data(), move_buf.size(), PLLMOD_COMMON_REDUCE_SUM);
+
+  std::vector<SPRMove> moves;
+  for (size_t j = 0; j < move_buf.size(); j += 3)
+  {
+    if (move_buf[j] < 0.)
+      moves.emplace_back(move_buf[j], (size_t) move_buf[j+1], (size_t) move_buf[j+2]);
+  }
+
+  /* stable sort -> identical commit order on all threads */
+  std::stable_sort(moves.begin(), moves.end(),
+                   [](const SPRMove& a, const SPRMove& b) { return std::get<0>(a) > std::get<0>(b); });
+
+  /* branch lengths snapshot: per-node lengths + per-partition lengths (unlinked mode) */
+  const bool unlinked = treeinfo->brlen_linkage == PLLMOD_COMMON_BRLEN_UNLINKED;
+  doubleVector saved_brlens(node_map.size());
+  std::vector<doubleVector> saved_part_brlens(unlinked ? treeinfo->partition_count : 0);
+  auto save_brlens = [&]()
+  {
+    for (size_t i = 0; i < node_map.size(); ++i)
+      saved_brlens[i] = node_map[i]->length;
+    for (size_t p = 0; p < saved_part_brlens.size(); ++p)
+    {
+      if (treeinfo->branch_lengths[p])
+        saved_part_brlens[p].assign(treeinfo->branch_lengths[p],
+                                    treeinfo->branch_lengths[p] + tree->edge_count);
+    }
+  };
+  auto restore_brlens = [&]()
+  {
+    for (size_t i = 0; i < node_map.size(); ++i)
+      node_map[i]->length = saved_brlens[i];
+    for (size_t p = 0; p < saved_part_brlens.size(); ++p)
+    {
+      if (treeinfo->branch_lengths[p])
+        std::copy(saved_part_brlens[p].cbegin(), saved_part_brlens[p].cend(),
+                  treeinfo->branch_lengths[p]);
+    }
+  };
+
+  /* commit moves, skipping the ones which became invalid or do not improve LH anymore */
+  size_t committed = 0;
+  for (const auto& move: moves)
+  {
+    auto p_edge = node_map.at(std::get<1>(move));
+    auto r_edge = node_map.at(std::get<2>(move));
+
+    spr_collect_regraft_edges(p_edge, 1, params.radius_max, regraft_edges, paths);
+    if (std::find(regraft_edges.begin(), regraft_edges.end(), r_edge) == regraft_edges.end())
+      continue;
+
+    /* neighborhoods of the old and new attachment points, marked as changed if move is kept */
+    const pll_unode_t * touched[] = {p_edge, p_edge->next->back, p_edge->next->next->back,
+                                     r_edge, r_edge->back};
+
+    /* thorough mode changes branch lengths around the insertion point, and SPR rollback
+     * only restores the lengths of the branches merged/split by the move itself */
+    if (params.thorough)
+      save_brlens();
+
+    if (!pllmod_utree_spr(p_edge, r_edge, &rollback))
+    {
+      libpll_reset_error();
+      continue;
+    }
+
+    pllmod_treeinfo_set_root(treeinfo, p_edge);
+    pllmod_treeinfo_invalidate_all(treeinfo);
+
+    if (params.thorough)
+    {
+      /* optimize branches around the insertion point */
+      pllmod_algo_opt_brlen_treeinfo(treeinfo, _brlen_min, _brlen_max,
+                                     params.lh_epsilon_brlen_triplet, RAXML_BRLEN_SMOOTHINGS,
+                                     _brlen_opt_method, 1);
+      libpll_check_error("ERROR in branch length optimization");
+      pllmod_treeinfo_invalidate_all(treeinfo);
+    }
+
+    double new_loglh = loglh();
+    if (new_loglh - best_loglh > lh_epsilon)
+    {
+      best_loglh = new_loglh;
+      committed++;
+
+      for (auto node: touched)
+        spr_touch_node(node);
+    }
+    else
+    {
+      pllmod_tree_rollback(&rollback);
+      if (params.thorough)
+        restore_brlens();
+      pllmod_treeinfo_invalidate_all(treeinfo);
+    }
+  }
+
+  _spr_moves = committed;
+
+  LOG_DEBUG << "Taxon-parallel SPR round: candidate moves: " << moves.size()
+            << ", committed: " << committed << endl;
+
+  if (_use_spr_cache)
+  {
+    auto lookups = _spr_cache_hits + _spr_cache_misses;
+    LOG_DEBUG << "SPR move cache: hits: " << _spr_cache_hits << ", misses: " << _spr_cache_misses
+              << ", hit rate: " << (lookups ? 100. * _spr_cache_hits / lookups : 0.) << "%" << endl;
+  }
+
+  pllmod_treeinfo_invalidate_all(treeinfo);
+  best_loglh = loglh();
+
+  assert(isfinite(best_loglh) && best_loglh);
+
+  return best_loglh;
+}
+
+/* apply random SPR moves (identical on all threads given the same seed and tree) */
+void TreeInfo::perturb_topology(unsigned int num_moves, int radius, unsigned long seed)
+{
+  auto tree = _pll_treeinfo->tree;
+
+  PllNodeVector prune_edges;
+  for (unsigned int i = tree->tip_count; i < tree->tip_count + tree->inner_count; ++i)
+  {
+    auto node = tree->nodes[i];
+    for (auto sub: {node, node->next, node->next->next})
+      prune_edges.push_back(sub);
+  }
+
+  std::mt19937 gen(seed);
+  PllNodeVector regraft_edges;
+  std::vector<PllNodeVector> paths;
+  pll_tree_rollback_t rollback;
+  for (unsigned int m = 0; m < num_moves; ++m)
+  {
+    auto p_edge = prune_edges.at(gen() % prune_edges.size());
+
+    spr_collect_regraft_edges(p_edge, 1, radius, regraft_edges, paths);
+    if (regraft_edges.empty())
+      continue;
+
+    auto r_edge = regraft_edges.at(gen() % regraft_edges.size());
+    if (!pllmod_utree_spr(p_edge, r_edge, &rollback))
+      libpll_reset_error();
+  }
+
+  pllmod_treeinfo_set_root(_pll_treeinfo, tree->vroot);
+  pllmod_treeinfo_invalidate_all(_pll_treeinfo);
+
+  _spr_cache.clear();
+}
+
 void TreeInfo::set_topology_constraint(const Tree& cons_tree)
 {
   if (!cons_tree.empty())
@@ -464,7 +1002,8 @@ void assign(Model& model, const TreeInfo& treeinfo, size_t partition_id)
     model.brlen_scaler(pll_treeinfo.brlen_scalers[partition_id]);
 }
 
-void build_clv(ProbVector::const_iterator probs, size_t sites, const WeightVector& weights, size_t seq_offset,
+template<typename T>
+void build_clv(const T * probs, size_t sites, const WeightVector& weights, size_t seq_offset,
                pll_partition_t* partition, bool normalize, std::vector<double>& clv)
 {
   const auto states = partition->states;
@@ -496,6 +1035,23 @@ void build_clv(ProbVector::const_iterator probs, size_t sites, const WeightVecto
   assert(clvp == clv.end());
 }
 
+/* probabilities are normalized on the fly while the tip CLV is being built */
+void build_clv(const MSA& msa, size_t seq_id, size_t sites, const WeightVector& weights,
+               size_t seq_offset, pll_partition_t* partition, bool normalize, std::vector<double>& clv)
+{
+  const auto& probs = msa.probs();
+  if (probs.single_precision())
+  {
+    build_clv(probs.data<float>(seq_id, seq_offset), sites, weights, seq_offset,
+              partition, normalize, clv);
+  }
+  else
+  {
+    build_clv(probs.data<double>(seq_id, seq_offset), sites, weights, seq_offset,
+              partition, normalize, clv);
+  }
+}
+
 void set_partition_tips(const Options& opts, const MSA& msa, const IDVector& tip_msa_idmap,
                         const PartitionRange& part_region,
                         pll_partition_t* partition, const pll_state_t * charmap)
@@ -522,17 +1078,18 @@ void set_partition_tips(const Options& opts, const MSA& msa, const IDVector& tip
     for (size_t tip_id = 0; tip_id < partition->tips; ++tip_id)
     {
       auto seq_id = tip_msa_idmap.empty() ? tip_id : tip_msa_idmap[tip_id];
-      auto prob_start = msa.probs(seq_id, seq_offset);
-      build_clv(prob_start, partition->sites, msa.weights(), seq_offset, partition, normalize, tmp_clv);
+      build_clv(msa, seq_id, partition->sites, msa.weights(), seq_offset, partition, normalize, tmp_clv);
       pll_set_tip_clv(partition, tip_id, tmp_clv.data(), PLL_FALSE);
     }
   }
   else
   {
+    std::vector<char> seq(partition->sites + 1, 0);
     for (size_t tip_id = 0; tip_id < partition->tips; ++tip_id)
     {
       auto seq_id = tip_msa_idmap.empty() ? tip_id : tip_msa_idmap[tip_id];
-      pll_set_tip_states(partition, tip_id, charmap, msa.at(seq_id).c_str() + seq_offset);
+      msa.sequence(seq_id, seq_offset, partition->sites, seq.data());
+      pll_set_tip_states(partition, tip_id, charmap, seq.data());
     }
   }
 }
@@ -570,23 +1127,23 @@ void set_partition_tips(const Options& opts, const MSA& msa, const IDVector& tip
     for (size_t tip_id = 0; tip_id < partition->tips; ++tip_id)
     {
       auto seq_id = tip_msa_idmap.empty() ? tip_id : tip_msa_idmap[tip_id];
-      auto prob_start = msa.probs(seq_id, pstart);
-      build_clv(prob_start, plen, weights, pstart, partition, normalize, tmp_clv);
+      build_clv(msa, seq_id, plen, weights, pstart, partition, normalize, tmp_clv);
       pll_set_tip_clv(partition, tip_id, tmp_clv.data(), PLL_FALSE);
     }
   }
   else
   {
     std::vector<char> bs_seq(plen);
+    std::vector<char> part_seq(plen);
     for (size_t tip_id = 0; tip_id < partition->tips; ++tip_id)
     {
       auto seq_id = tip_msa_idmap.empty() ? tip_id : tip_msa_idmap[tip_id];
-      const char * full_seq = msa.at(seq_id).c_str();
+      msa.sequence(seq_id, pstart, plen, part_seq.data());
       size_t pos = 0;
       for (size_t j = pstart; j < pend; ++j)
       {
         if (weights[j] > 0)
-          bs_seq[pos++] = full_seq[j];
+          bs_seq[pos++] = part_seq[j - pstart];
       }
       assert(pos == comp_weights.size());
 
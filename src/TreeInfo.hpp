@@ -1,6 +1,8 @@
 #ifndef RAXML_TREEINFO_HPP_
 #define RAXML_TREEINFO_HPP_
 
+#include <unordered_map>
+
 #include "common.h"
 #include "Tree.hpp"
 #include "Options.hpp"
@@ -44,6 +46,10 @@ public:
   Tree tree(size_t partition_id) const;
   void tree(const Tree& tree);
 
+  /* change topology and branch lengths in-place (tree structure must be compatible) */
+  void topology(const TreeTopology& topol);
+  void perturb_topology(unsigned int num_moves, int radius, unsigned long seed);
+
   /* in parallel mode, partition can be share among multiple threads and TreeInfo objects;
    * this method returns list of partition IDs for which this thread is designated as "master"
    * and thus responsible for e.g. sending model parameters to the main thread. */
@@ -62,6 +68,10 @@ public:
   { return optimize_params(PLLMOD_OPT_PARAM_ALL & ~PLLMOD_OPT_PARAM_BRANCHES_ITERATIVE, lh_epsilon); } ;
   double optimize_branches(double lh_epsilon, double brlen_smooth_factor);
   double spr_round(spr_round_params& params);
+  /* taxon-parallel mode: every thread holds all alignment sites */
+  bool taxon_parallel() const { return _use_spr_taxpar; }
+  /* number of moves applied in the last SPR round (-1 if unknown) */
+  long spr_moves() const { return _spr_moves; }
   void compute_ancestral(const AncestralStatesSharedPtr& ancestral,
                          const PartitionAssignment& part_assign);
 
@@ -74,13 +84,43 @@ private:
   bool _check_lh_impr;
   bool _use_old_constraint;
   bool _use_spr_fastclv;
+  bool _use_spr_taxpar;
+  bool _use_local_modopt;
+  long _spr_moves;
+  std::vector<bool> _parts_local;
   doubleVector _partition_contributions;
 
+  /* SPR move cache (taxon-parallel mode): pruning points without improving moves in a previous
+   * round are skipped as long as the topology around them, the model parameters and (up to
+   * RAXML_SPR_CACHE_BRLEN_EPS) the branch lengths remain unchanged. Entries are keyed by the
+   * split hash of the pruned subtree */
+  struct SPRCacheEntry
+  {
+    uint64_t region_stamp;
+    double lh_gain;
+  };
+  bool _use_spr_cache;
+  std::unordered_map<uint64_t, SPRCacheEntry> _spr_cache;
+  uintVector _node_versions;
+  size_t _spr_cache_epoch;
+  size_t _spr_cache_hits;
+  size_t _spr_cache_misses;
+
   void init(const Options &opts, const Tree& tree, const PartitionedMSA& parted_msa,
             const IDVector& tip_msa_idmap, const PartitionAssignment& part_assign,
             const std::vector<uintVector>& site_weights);
 
   void assert_lh_improvement(double old_lh, double new_lh, const std::string& where = "");
+
+  double spr_round_taxpar(spr_round_params& params);
+  uint64_t spr_region_stamp(pll_unode_t * p_edge, const PllNodeVector& regraft_edges,
+                            const spr_round_params& params) const;
+  void spr_touch_node(const pll_unode_t * node);
+  void spr_subtree_hashes(const PllNodeVector& node_map, std::vector<uint64_t>& hashes) const;
+
+  double optimize_params_impl(int params_to_optimize, double lh_epsilon);
+  double optimize_params_local(int params_to_optimize, double lh_epsilon);
+  void init_parts_local();
 };
 
 void assign(PartitionedMSA& parted_msa, const TreeInfo& treeinfo);
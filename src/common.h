@@ -34,6 +34,7 @@ void libpll_check_error(const std::string& errmsg = "ERROR in libpll", bool forc
 void libpll_reset_error();
 
 double sysutil_gettime();
+double sysutil_get_thread_cputime();
 void sysutil_show_rusage();
 unsigned long sysutil_get_memused();
 unsigned long sysutil_get_memtotal(bool ignore_errors = true);
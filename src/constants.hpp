@@ -36,6 +36,42 @@
 
 #define RAXML_DEFAULT_PRECISION   6
 
+/* parameters for estimating site repeats compression ratio in load balancing */
+#define RAXML_REPEATS_SAMPLE_SITES     1000
+#define RAXML_REPEATS_SAMPLE_SUBTREES  4
+#define RAXML_REPEATS_MAX_RATIO        0.99
+#define RAXML_REPEATS_MIN_WEIGHT       0.05
+
+/* max. number of SPR moves per thread to be exchanged in taxon-parallel mode */
+#define RAXML_SPR_TAXPAR_MOVES         16
+
+/* SPR move cache: branch length re-optimization which changes logLH by more than this
+ * invalidates all cached entries (model parameter optimization always does) */
+#define RAXML_SPR_CACHE_BRLEN_EPS      0.1
+
+/* rapid bootstrap search schedule: fixed SPR radius and LH epsilon */
+#define RAXML_RAPID_BS_SPR_RADIUS      10
+#define RAXML_RAPID_BS_LH_EPSILON      1.0
+
+/* cooperative search: adopt best concurrent tree if lagging by this margin, then perturb it */
+#define RAXML_SEARCH_COOP_MARGIN       10.0
+#define RAXML_SEARCH_COOP_MOVES        3
+#define RAXML_SEARCH_COOP_RADIUS       3
+
+/* starting tree triage: fraction of non-top trees selected at random for full search */
+#define RAXML_TRIAGE_RANDOM_FRACTION   0.1
+
+/* adaptive convergence thresholds: epsilons are scaled by sqrt(#patterns / REF_PATTERNS) */
+#define RAXML_ADAPTIVE_EPS_REF_PATTERNS   10000
+/* adaptive convergence thresholds: stop SPR loops below this (scaled) logLH gain per second */
+#define RAXML_ADAPTIVE_EPS_MIN_RATE       0.01
+
+/* parsimony collapse-and-resolve: fraction of inner branches collapsed and re-resolved in every iteration */
+#define RAXML_PARS_COLLAPSE_FRACTION   0.1
+
+/* pattern compression: minimum number of alignment columns per thread */
+#define RAXML_PATCOMP_MIN_SITES   10000
+
 #define RAXML_BOOTSTOP_CUTOFF     0.03
 #define RAXML_BOOTSTOP_INTERVAL   50
 #define RAXML_BOOTSTOP_PERMUTES   1000
@@ -133,6 +133,21 @@ public:
 
   bool good() const { return _fstream.good(); }
 
+  /* absolute positioning, needed for indexed formats (e.g. RBA v3) */
+  size_t tell() { return (size_t) _fstream.rdbuf()->pubseekoff(0, std::ios_base::cur); }
+  void seek(size_t pos)
+  {
+    _fstream.clear();
+    _fstream.seekg(pos, std::ios_base::beg);
+  }
+  size_t file_size()
+  {
+    const auto cur = tell();
+    const auto size = (size_t) _fstream.rdbuf()->pubseekoff(0, std::ios_base::end);
+    seek(cur);
+    return size;
+  }
+
 private:
   std::fstream _fstream;
 };
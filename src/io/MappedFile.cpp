@@ -0,0 +1,53 @@
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "MappedFile.hpp"
+
+using namespace std;
+
+MappedFile::MappedFile(const std::string& fname, Access access) : _fname(fname), _data(nullptr), _size(0)
+{
+  int fd = open(fname.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw runtime_error("Unable to open file: " + fname);
+
+  struct stat st;
+  if (fstat(fd, &st) != 0)
+  {
+    close(fd);
+    throw runtime_error("Unable to stat file: " + fname);
+  }
+
+  _size = (size_t) st.st_size;
+
+  /* mmap() does not accept zero-length mappings */
+  if (_size > 0)
+  {
+    void * addr = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED)
+    {
+      close(fd);
+      throw runtime_error("Unable to map file into memory: " + fname);
+    }
+
+    if (access == Access::sequential)
+      madvise(addr, _size, MADV_SEQUENTIAL);
+    else if (access == Access::random)
+      madvise(addr, _size, MADV_RANDOM);
+
+    _data = (const char *) addr;
+  }
+
+  /* mapping stays valid after the descriptor is closed */
+  close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+  if (_data)
+    munmap((void *) _data, _size);
+}
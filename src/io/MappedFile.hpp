@@ -0,0 +1,40 @@
+#ifndef RAXML_IO_MAPPEDFILE_HPP_
+#define RAXML_IO_MAPPEDFILE_HPP_
+
+#include <string>
+
+/* Read-only memory mapping of a whole file (RAII). Used by the native MSA parsers
+ * to avoid copying the input through stdio buffers, and for zero-copy RBA loading. */
+class MappedFile
+{
+public:
+  /* expected access pattern, passed on to the kernel via madvise() */
+  enum class Access
+  {
+    normal = 0,     /* no advice: default read-ahead */
+    sequential,     /* single front-to-back scan (parsers) */
+    random
+  };
+
+  MappedFile(const std::string& fname, Access access);
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  const char * data() const { return _data; }
+  size_t size() const { return _size; }
+  bool empty() const { return _size == 0; }
+
+  const char * begin() const { return _data; }
+  const char * end() const { return _data + _size; }
+
+  const std::string& fname() const { return _fname; }
+
+private:
+  std::string _fname;
+  const char * _data;
+  size_t _size;
+};
+
+#endif /* RAXML_IO_MAPPEDFILE_HPP_ */
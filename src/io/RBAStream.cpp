@@ -1,12 +1,18 @@
 #include "file_io.hpp"
 #include "binary_io.hpp"
+#include "MappedFile.hpp"
 
 using namespace std;
 
 const uint64_t RBA_MAGIC       = *(reinterpret_cast<const uint64_t*>("RBAF\x13\x12\x17\x0A"));
-const uint32_t RBA_VERSION     = 2;
+const uint64_t RBA_INDEX_MAGIC = *(reinterpret_cast<const uint64_t*>("RBAI\x13\x12\x17\x0A"));
+const uint32_t RBA_VERSION     = 4;
 const uint32_t RBA_MIN_VERSION = 2;
 
+/* RBA v3: alignment data is stored in column blocks of roughly this size */
+const size_t RBA_BLOCK_BYTES      = 1024 * 1024;
+const size_t RBA_MIN_BLOCK_SITES  = 64;
+
 struct RBAHeader
 {
   uint64_t magic;
@@ -26,6 +32,273 @@ struct RBAHeader
       {}
 };
 
+/*
+ * RBA v3 layout:
+ *
+ *   header | taxon labels | partition metadata | column blocks | index | index offset, magic
+ *
+ * RBA v4: same as v3, but partition metadata also includes the site repeats ratio estimated
+ * on the full alignment (needed for load balancing with partial loading).
+ *
+ * Column block payload: pattern weights (optional) followed by the block characters of all
+ * taxa (taxon-major), the latter encoded with the block codec (see BlockSequences). The index
+ * at the end of the file stores offset, size, codec and CRC32 of every block, so that any range
+ * of alignment columns can be loaded without reading the rest of the file.
+ */
+struct RBABlockInfo
+{
+  uint64_t offset;
+  uint64_t size;
+  uint32_t crc;
+  uint8_t codec;
+};
+
+struct RBAPartIndex
+{
+  uint64_t taxon_count;
+  uint64_t pattern_count;
+  uint8_t has_weights;
+  vector<RBABlockInfo> blocks;
+};
+
+struct RBAIndex
+{
+  uint64_t block_sites;
+  vector<RBAPartIndex> parts;
+};
+
+static vector<uint32_t> rba_crc32_table()
+{
+  vector<uint32_t> table(256);
+  for (uint32_t i = 0; i < 256; ++i)
+  {
+    uint32_t c = i;
+    for (int k = 0; k < 8; ++k)
+      c = (c & 1) ? 0xEDB88320U ^ (c >> 1) : c >> 1;
+    table[i] = c;
+  }
+  return table;
+}
+
+/* standard CRC-32 (IEEE 802.3) */
+static uint32_t rba_crc32(const char * data, size_t size)
+{
+  static const vector<uint32_t> table = rba_crc32_table();
+
+  uint32_t crc = 0xFFFFFFFFU;
+  for (size_t i = 0; i < size; ++i)
+    crc = table[(crc ^ (unsigned char) data[i]) & 0xFF] ^ (crc >> 8);
+
+  return crc ^ 0xFFFFFFFFU;
+}
+
+static size_t rba_block_sites(size_t taxon_count)
+{
+  return std::max(RBA_MIN_BLOCK_SITES, RBA_BLOCK_BYTES / std::max<size_t>(taxon_count, 1));
+}
+
+static void write_index(BinaryFileStream& bos, const RBAIndex& index)
+{
+  bos << index.block_sites;
+  for (const auto& pidx: index.parts)
+  {
+    bos << pidx.taxon_count << pidx.pattern_count << pidx.has_weights;
+    bos << (uint64_t) pidx.blocks.size();
+    for (const auto& b: pidx.blocks)
+      bos << b.offset << b.size << b.crc << b.codec;
+  }
+}
+
+static RBAIndex read_index(BinaryFileStream& bos, size_t part_count)
+{
+  const auto file_size = bos.file_size();
+  const size_t trailer_size = 2 * sizeof(uint64_t);
+
+  if (file_size < trailer_size)
+    throw runtime_error("RBA file is truncated!");
+
+  bos.seek(file_size - trailer_size);
+  auto index_offset = bos.get<uint64_t>();
+  auto magic = bos.get<uint64_t>();
+
+  if (!bos.good() || magic != RBA_INDEX_MAGIC || index_offset >= file_size)
+    throw runtime_error("RBA file index not found (file is truncated?)");
+
+  bos.seek(index_offset);
+
+  RBAIndex index;
+  bos >> index.block_sites;
+  index.parts.resize(part_count);
+  for (auto& pidx: index.parts)
+  {
+    bos >> pidx.taxon_count >> pidx.pattern_count >> pidx.has_weights;
+    auto block_count = bos.get<uint64_t>();
+    if (!bos.good() || !index.block_sites ||
+        block_count != (pidx.pattern_count + index.block_sites - 1) / index.block_sites)
+    {
+      throw runtime_error("RBA file index is corrupted!");
+    }
+    pidx.blocks.resize(block_count);
+    for (auto& b: pidx.blocks)
+      bos >> b.offset >> b.size >> b.crc >> b.codec;
+  }
+
+  if (!bos.good())
+    throw runtime_error("RBA file index is corrupted!");
+
+  return index;
+}
+
+/* decoded column block */
+struct RBABlock
+{
+  size_t part;
+  size_t id;
+  WeightVector weights;
+  string chars;           /* taxon-major */
+
+  RBABlock() : part(SIZE_MAX), id(SIZE_MAX) {}
+};
+
+static void read_block(BinaryFileStream& bos, const RBAIndex& index, size_t part, size_t id,
+                       RBABlock& block)
+{
+  if (block.part == part && block.id == id)
+    return;
+
+  const auto& pidx = index.parts.at(part);
+  const auto& binfo = pidx.blocks.at(id);
+
+  const size_t start = id * index.block_sites;
+  const size_t len = std::min<size_t>(index.block_sites, pidx.pattern_count - start);
+  const size_t weights_size = pidx.has_weights ? len * sizeof(WeightVector::value_type) : 0;
+
+  vector<char> payload(binfo.size);
+  bos.seek(binfo.offset);
+  bos.read(payload.data(), binfo.size);
+
+  if (!bos.good() || binfo.size < weights_size)
+    throw runtime_error("RBA file is truncated!");
+
+  if (rba_crc32(payload.data(), payload.size()) != binfo.crc)
+  {
+    throw runtime_error("RBA file is corrupted (CRC mismatch in partition " + to_string(part+1) +
+                        ", block " + to_string(id+1) + ")!");
+  }
+
+  block.weights.resize(pidx.has_weights ? len : 0);
+  if (weights_size)
+    memcpy(block.weights.data(), payload.data(), weights_size);
+
+  block.chars.resize(pidx.taxon_count * len);
+  BlockSequences::decode_block(payload.data() + weights_size, payload.size() - weights_size,
+                               binfo.codec, block.chars);
+
+  block.part = part;
+  block.id = id;
+}
+
+/* load alignment columns given by rl (or all columns if rl is empty) of a partition */
+static void read_part_msa(BinaryFileStream& bos, const RBAIndex& index, size_t part,
+                          const RangeList& rl, MSA& m)
+{
+  const auto& pidx = index.parts.at(part);
+  const auto taxa = pidx.taxon_count;
+  const auto bs = index.block_sites;
+
+  RangeList ranges;
+  if (rl.empty())
+  {
+    m = MSA(pidx.pattern_count);
+    ranges.emplace_back(0, pidx.pattern_count);
+  }
+  else
+  {
+    m = MSA(rl);
+    ranges = m.local_seq_ranges();
+  }
+
+  const auto local_len = m.num_sites();
+  vector<string> seqs(taxa, string(local_len, 0));
+  WeightVector w(pidx.has_weights ? local_len : 0);
+
+  RBABlock block;
+  size_t pos = 0;
+  for (const auto& r: ranges)
+  {
+    if (r.start + r.length > pidx.pattern_count)
+      throw runtime_error("RBAStream: alignment range is out of bounds!");
+
+    for (size_t j = r.start; j < r.start + r.length; )
+    {
+      const auto id = j / bs;
+      read_block(bos, index, part, id, block);
+
+      const auto bstart = id * bs;
+      const auto blen = std::min<size_t>(bs, pidx.pattern_count - bstart);
+      const auto count = std::min(r.start + r.length, bstart + blen) - j;
+      const auto boffset = j - bstart;
+
+      if (!w.empty())
+        std::copy_n(block.weights.cbegin() + boffset, count, w.begin() + pos);
+
+      for (size_t i = 0; i < taxa; ++i)
+        memcpy(&seqs[i][pos], block.chars.data() + i * blen + boffset, count);
+
+      j += count;
+      pos += count;
+    }
+  }
+  assert(pos == local_len);
+
+  if (!w.empty())
+    m.weights(std::move(w));
+
+  for (auto& s: seqs)
+    m.append(std::move(s));
+}
+
+/* zero-copy load of a whole partition: sequences reference the mapped file directly,
+ * only the pattern weights are copied */
+static void map_part_msa(const shared_ptr<MappedFile>& mfile, const RBAIndex& index, size_t part,
+                         MSA& m)
+{
+  const auto& pidx = index.parts.at(part);
+  const auto len = pidx.pattern_count;
+  const auto bs = index.block_sites;
+
+  BlockSequences seqs;
+  seqs.init(pidx.taxon_count, len, bs, mfile);
+
+  WeightVector w(pidx.has_weights ? len : 0);
+  for (size_t id = 0; id < pidx.blocks.size(); ++id)
+  {
+    const auto& binfo = pidx.blocks[id];
+    const size_t start = id * bs;
+    const size_t blen = std::min<size_t>(bs, len - start);
+    const size_t weights_size = w.empty() ? 0 : blen * sizeof(WeightVector::value_type);
+
+    if (binfo.offset + binfo.size > mfile->size() || binfo.size < weights_size)
+      throw runtime_error("RBA file is truncated!");
+
+    const char * payload = mfile->data() + binfo.offset;
+    if (rba_crc32(payload, binfo.size) != binfo.crc)
+    {
+      throw runtime_error("RBA file is corrupted (CRC mismatch in partition " + to_string(part+1) +
+                          ", block " + to_string(id+1) + ")!");
+    }
+
+    if (weights_size)
+      memcpy(w.data() + start, payload, weights_size);
+
+    seqs.add_block(payload + weights_size, binfo.size - weights_size, binfo.codec);
+  }
+
+  m = MSA(std::move(seqs));
+  if (!w.empty())
+    m.weights(std::move(w));
+}
+
 bool RBAStream::rba_file(const std::string& fname, bool check_version)
 {
   BinaryFileStream bos(fname, std::ios::in);
@@ -67,14 +340,62 @@ RBAStream& operator<<(RBAStream& stream, const PartitionedMSA& part_msa)
     bos << pinfo.range_string();
     bos << pinfo.stats();
     bos << std::make_tuple(std::ref(pinfo.model()), ModelBinaryFmt::full);
+    bos << pinfo.repeats_ratio();
   }
 
-  // per-partition alignment blocks
+  // per-partition alignment data, split into column blocks
+  RBAIndex index;
+  index.block_sites = rba_block_sites(part_msa.taxon_count());
+  const auto bs = index.block_sites;
   for (const auto& pinfo: part_msa.part_list())
   {
-    bos << pinfo.msa();
+    const auto& m = pinfo.msa();
+    const auto taxa = m.size();
+    const auto len = m.length();
+
+    RBAPartIndex pidx;
+    pidx.taxon_count = taxa;
+    pidx.pattern_count = len;
+    pidx.has_weights = !m.weights().empty();
+
+    string chars;
+    vector<char> payload;
+    for (size_t start = 0; start < len; start += bs)
+    {
+      const auto blen = std::min(bs, len - start);
+
+      payload.clear();
+      if (pidx.has_weights)
+      {
+        auto w = (const char *) (m.weights().data() + start);
+        payload.insert(payload.end(), w, w + blen * sizeof(WeightVector::value_type));
+      }
+
+      chars.resize(taxa * blen);
+      for (size_t i = 0; i < taxa; ++i)
+        m.sequence(i, start, blen, &chars[i * blen]);
+
+      RBABlockInfo binfo;
+      binfo.codec = BlockSequences::encode_block(chars, stream.compress(), payload);
+      binfo.offset = bos.tell();
+      binfo.size = payload.size();
+      binfo.crc = rba_crc32(payload.data(), payload.size());
+      pidx.blocks.push_back(binfo);
+
+      bos.write(payload.data(), payload.size());
+    }
+
+    index.parts.push_back(std::move(pidx));
   }
 
+  // block index + trailer
+  const uint64_t index_offset = bos.tell();
+  write_index(bos, index);
+  bos << index_offset << RBA_INDEX_MAGIC;
+
+  if (!bos.good())
+    throw runtime_error("Error writing RBA file: " + stream.fname());
+
   return stream;
 }
 
@@ -147,13 +468,50 @@ RBAStream& operator>>(RBAStream& stream, RBAStream::RBAOutput out)
 
     bos >> mtuple;
 
+    double repeats_ratio = -1.;
+    if (header.version >= 4)
+      bos >> repeats_ratio;
+
 //    LOG_INFO << m << endl;
 
     if (load_meta)
+    {
       part_msa.emplace_part_info(pname, pstats, m, prange);
+      part_msa.part_list().back().repeats_ratio(repeats_ratio);
+    }
   }
 
-  if (load_seq)
+  if (load_seq && header.version >= 3)
+  {
+    /* indexed format: read only the column blocks which overlap the requested ranges */
+    auto index = read_index(bos, header.part_count);
+
+    std::vector<RangeList> part_ranges(part_msa.part_count());
+    if (pa)
+    {
+      for (const auto& pr: *pa)
+        part_ranges[pr.part_id].emplace_back(pr.start, pr.length);
+    }
+
+    /* whole alignment is needed -> map the file instead of copying it to the heap,
+     * this way all ranks on a node share the same page cache copy. The mapping is
+     * accessed block-wise during the whole run (not a single scan), hence no
+     * sequential advice: it would let the kernel drop pages behind the CRC check */
+    shared_ptr<MappedFile> mfile;
+    if (!pa && stream.use_mmap())
+      mfile = make_shared<MappedFile>(stream.fname(), MappedFile::Access::normal);
+
+    for (size_t p = 0; p < part_msa.part_count(); ++p)
+    {
+      auto& pinfo = part_msa.part_list().at(p);
+      ensure_equal("taxon count", index.parts[p].taxon_count, header.taxon_count);
+      if (mfile)
+        map_part_msa(mfile, index, p, pinfo.msa());
+      else if (!pa || !part_ranges[p].empty())
+        read_part_msa(bos, index, p, part_ranges[p], pinfo.msa());
+    }
+  }
+  else if (load_seq)
   {
     if (!pa)
     {
@@ -190,4 +548,3 @@ RBAStream& operator>>(RBAStream& stream, RBAStream::RBAOutput out)
 
   return stream;
 }
-
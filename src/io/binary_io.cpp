@@ -297,7 +297,7 @@ BasicBinaryStream& operator<<(BasicBinaryStream& stream, const MSA& m)
 
   for (size_t i = 0; i < m.size(); ++i)
   {
-    auto seq = m.at(i);
+    auto seq = m.sequence(i);
     assert(seq.length() == m.length());
     stream.write(seq.c_str(), m.length());
   }
@@ -27,12 +27,17 @@ class MSAFileStream
 {
 public:
   MSAFileStream(const std::string& fname) :
-    _fname(fname) {}
+    _fname(fname), _num_threads(1) {}
 
   const std::string& fname() const { return _fname; };
 
+  /* number of threads the native parsers may use */
+  unsigned int num_threads() const { return _num_threads; }
+  void num_threads(unsigned int n) { _num_threads = n > 0 ? n : 1; }
+
 private:
   std::string _fname;
+  unsigned int _num_threads;
 };
 
 class PhylipStream : public MSAFileStream
@@ -60,7 +65,21 @@ private:
 class CATGStream : public MSAFileStream
 {
 public:
-  CATGStream(const std::string& fname) : MSAFileStream(fname) {}
+  CATGStream(const std::string& fname) : MSAFileStream(fname), _single_precision(false) {}
+
+  /* store state probabilities as float instead of double */
+  bool single_precision() const { return _single_precision; }
+  void single_precision(bool value) { _single_precision = value; }
+private:
+  bool _single_precision;
+};
+
+/* genotype data: only bi-/multi-allelic SNVs are used, with unique patterns stored
+ * only once (MSA comes with site weights) */
+class VCFStream : public MSAFileStream
+{
+public:
+  VCFStream(const std::string& fname) : MSAFileStream(fname) {}
 };
 
 class RBAStream : public MSAFileStream
@@ -76,9 +95,20 @@ public:
   typedef std::tuple<PartitionedMSA&, RBAElement, PartitionAssignment*> RBAOutput;
 
 public:
-  RBAStream(const std::string& fname) : MSAFileStream(fname) {}
+  RBAStream(const std::string& fname) : MSAFileStream(fname), _compress(true), _use_mmap(true) {}
 
   static bool rba_file(const std::string& fname, bool check_version = false);
+
+  /* use lightweight per-block compression when writing */
+  bool compress() const { return _compress; }
+  void compress(bool value) { _compress = value; }
+
+  /* full loads: MSA references memory-mapped file instead of a heap copy (RBA v3+) */
+  bool use_mmap() const { return _use_mmap; }
+  void use_mmap(bool value) { _use_mmap = value; }
+private:
+  bool _compress;
+  bool _use_mmap;
 };
 
 class RaxmlPartitionStream : public std::fstream
@@ -157,7 +187,12 @@ NewickStream& operator<<(NewickStream& stream, const SupportTree& tree);
 PhylipStream& operator>>(PhylipStream& stream, MSA& msa);
 FastaStream& operator>>(FastaStream& stream, MSA& msa);
 CATGStream& operator>>(CATGStream& stream, MSA& msa);
-MSA msa_load_from_file(const std::string &filename, const FileFormat format);
+VCFStream& operator>>(VCFStream& stream, MSA& msa);
+/* guess the MSA file format(s) from the first few KB of the file, most likely first;
+ * returns an empty list if the format could not be determined */
+std::vector<FileFormat> msa_sniff_format(const std::string& filename);
+MSA msa_load_from_file(const std::string &filename, const FileFormat format,
+                        unsigned int num_threads = 1, bool prob_single_precision = false);
 
 PhylipStream& operator<<(PhylipStream& stream, const MSA& msa);
 PhylipStream& operator<<(PhylipStream& stream, const PartitionedMSA& msa);
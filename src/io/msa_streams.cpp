@@ -1,101 +1,339 @@
 #include <stdexcept>
 #include <algorithm>
 #include <map>
+#include <cstring>
+#include <unordered_map>
 
 #include "file_io.hpp"
+#include "MappedFile.hpp"
+#include "../util/threadutil.hpp"
 
 using namespace std;
 
-FastaStream& operator>>(FastaStream& stream, MSA& msa)
+/* native FASTA/PHYLIP parsers: the input file is memory-mapped and sequences are written
+ * directly into the std::string buffers which are later moved into the MSA object */
+
+/* smallest file chunk worth handing over to a separate parser thread */
+static const size_t MSA_PARSE_MIN_CHUNK = 4 * 1024 * 1024;
+
+enum CharStatus : unsigned char
 {
-  /* open the file */
-  auto file = pll_fasta_open(stream.fname().c_str(), pll_map_generic);
-  if (!file)
-    libpll_check_error("Unable to parse FASTA file");
-
-  char * sequence = NULL;
-  char * header = NULL;
-  long sequence_length;
-  long header_length;
-  long sequence_number;
-
-  /* read sequences and make sure they are all of the same length */
-  int sites = 0;
-
-  /* read the rest */
-  while (pll_fasta_getnext(file, &header, &header_length, &sequence, &sequence_length, &sequence_number))
+  CHAR_ILLEGAL = 0,
+  CHAR_LEGAL   = 1,
+  CHAR_SPACE   = 2
+};
+
+/* printable ASCII characters are accepted here, the actual state mapping
+ * (and hence datatype-specific validation) happens later in libpll */
+struct CharStatusTable
+{
+  CharStatusTable()
   {
-    if (!sites)
-    {
-      /* first sequence, init the MSA object */
-      if (sequence_length == -1 || sequence_length == 0)
-        throw runtime_error{"Unable to parse FASTA file"};
+    for (int c = 0; c < 256; ++c)
+      status[c] = (c > 32 && c < 127) ? CHAR_LEGAL : CHAR_ILLEGAL;
 
-      sites = sequence_length;
+    status[(unsigned char) ' '] = status[(unsigned char) '\t'] = CHAR_SPACE;
+    status[(unsigned char) '\n'] = status[(unsigned char) '\r'] = CHAR_SPACE;
+    status[(unsigned char) '\v'] = status[(unsigned char) '\f'] = CHAR_SPACE;
+  }
 
-      msa = MSA(sites);
-    }
-    else
-    {
-      if (sequence_length != sites)
-        throw runtime_error{"FASTA file does not contain equal size sequences"};
-    }
+  unsigned char operator[](char c) const { return status[(unsigned char) c]; }
 
-    if (!header_length)
-    {
-      throw runtime_error{"FASTA file contains empty sequence label: " + to_string(msa.size() + 1) };
-    }
+  unsigned char status[256];
+};
 
-    if (!sequence_length)
-    {
-      throw runtime_error{"FASTA file contains empty sequence:" + string(header) };
-    }
+static const CharStatusTable& char_status()
+{
+  static const CharStatusTable table;
+  return table;
+}
 
-    /* trim trailing whitespace from the sequence label */
-    std::string label(header);
-    label.erase(label.find_last_not_of(" \n\r\t")+1);
+static string illegal_char_error(char c, const string& label)
+{
+  const auto code = (unsigned int) (unsigned char) c;
+  return "Illegal character (ASCII code " + to_string(code) + ") in the sequence of taxon: " + label;
+}
 
-    /* two ways to deal with spaces in headers: */
-    if (stream.long_labels())
-    {
-      /* 1. replace spaces with underscores -> full header is sequence label */
-      std::replace(label.begin(), label.end(), ' ', '_');
-    }
-    else
+/* copies sequence characters from [p, end) to out[len..max_len), skipping whitespace.
+ * returns the new sequence length or max_len+1 on overflow */
+static size_t copy_seq_chars(const char * p, const char * end, char * out, size_t len,
+                             size_t max_len, const string& label)
+{
+  const auto& status = char_status();
+  for (; p < end; ++p)
+  {
+    const auto s = status[*p];
+    if (s == CHAR_LEGAL)
     {
-      /* 2. everything after the first space is considered "comment" and ignored */
-      auto p = label.find(' ');
-      if (p != string::npos)
-        label.erase(p);
+      if (len == max_len)
+        return max_len + 1;
+      out[len++] = *p;
     }
+    else if (s != CHAR_SPACE)
+      throw runtime_error(illegal_char_error(*p, label));
+  }
+  return len;
+}
+
+static inline const char * skip_space(const char * p, const char * end)
+{
+  const auto& status = char_status();
+  while (p < end && status[*p] == CHAR_SPACE)
+    ++p;
+  return p;
+}
 
-    msa.append(sequence, label);
-    free(sequence);
-    free(header);
+static inline const char * line_end(const char * p, const char * end)
+{
+  auto nl = (const char *) memchr(p, '\n', end - p);
+  return nl ? nl : end;
+}
+
+static string fasta_label(const char * begin, const char * end, bool long_labels)
+{
+  string label(begin, end);
+
+  /* trim trailing whitespace from the sequence label */
+  label.erase(label.find_last_not_of(" \n\r\t")+1);
+
+  /* two ways to deal with spaces in headers: */
+  if (long_labels)
+  {
+    /* 1. replace spaces with underscores -> full header is sequence label */
+    std::replace(label.begin(), label.end(), ' ', '_');
+  }
+  else
+  {
+    /* 2. everything after the first space is considered "comment" and ignored */
+    auto p = label.find(' ');
+    if (p != string::npos)
+      label.erase(p);
   }
 
-  if (pll_errno != PLL_ERROR_FILE_EOF)
-    libpll_check_error("Error parsing FASTA file: " +  stream.fname() + "\n");
+  return label;
+}
+
+FastaStream& operator>>(FastaStream& stream, MSA& msa)
+{
+  MappedFile file(stream.fname(), MappedFile::Access::sequential);
+
+  const char * data = file.data();
+  const char * data_end = file.end();
+
+  const char * first = skip_space(data, data_end);
+  if (first == data_end || *first != '>')
+    throw runtime_error{"Unable to parse FASTA file"};
+
+  /* index record boundaries: every '>' at the beginning of a line starts a new record */
+  const size_t first_pos = first - data;
+  const size_t scan_size = file.size() - first_pos;
+  const auto num_threads = (unsigned int) std::min<size_t>(stream.num_threads(),
+                                                           scan_size / MSA_PARSE_MIN_CHUNK + 1);
+  vector<vector<size_t>> block_starts(num_threads);
+  parallel_blocks(scan_size, num_threads,
+                  [&](size_t t, size_t begin, size_t end)
+                  {
+                    auto& starts = block_starts[t];
+                    const char * p = first + begin;
+                    const char * p_end = first + end;
+                    while (p < p_end)
+                    {
+                      p = (const char *) memchr(p, '>', p_end - p);
+                      if (!p)
+                        break;
+                      if (p == first || p[-1] == '\n')
+                        starts.push_back(p - data);
+                      ++p;
+                    }
+                  });
+
+  vector<size_t> starts;
+  for (const auto& s: block_starts)
+    starts.insert(starts.end(), s.cbegin(), s.cend());
+  block_starts.clear();
+
+  assert(!starts.empty() && starts[0] == first_pos);
+
+  const size_t taxa = starts.size();
+  starts.push_back(file.size());
+
+  vector<string> labels(taxa);
+  vector<string> sequences(taxa);
+
+  auto parse_record = [&](size_t i, size_t sites)
+    {
+      const char * header = data + starts[i] + 1;
+      const char * rec_end = data + starts[i+1];
+      const char * header_end = line_end(header, rec_end);
+
+      labels[i] = fasta_label(header, header_end, stream.long_labels());
+      if (labels[i].empty())
+        throw runtime_error{"FASTA file contains empty sequence label: " + to_string(i + 1) };
+
+      /* first sequence: record size is an upper bound for the sequence length */
+      auto& seq = sequences[i];
+      const size_t max_len = sites ? sites : rec_end - header_end;
+      seq.resize(max_len);
+
+      auto len = copy_seq_chars(header_end, rec_end, &seq[0], 0, max_len, labels[i]);
+
+      if (!len)
+        throw runtime_error{"FASTA file contains empty sequence: " + labels[i] };
+      else if (sites && len != sites)
+        throw runtime_error{"FASTA file does not contain equal size sequences"};
+
+      if (!sites)
+      {
+        seq.resize(len);
+        seq.shrink_to_fit();
+      }
+    };
+
+  /* first sequence determines the alignment width */
+  parse_record(0, 0);
+  const size_t sites = sequences[0].length();
 
-  pll_fasta_close(file);
+  parallel_blocks(taxa - 1, num_threads,
+                  [&](size_t, size_t begin, size_t end)
+                  {
+                    for (size_t i = begin; i < end; ++i)
+                      parse_record(i + 1, sites);
+                  });
 
-  libpll_reset_error();
+  msa = MSA(sites);
+  for (size_t i = 0; i < taxa; ++i)
+    msa.append(std::move(sequences[i]), labels[i]);
 
   return stream;
 }
 
+static const char * phylip_read_uint(const char * p, const char * end, size_t& value)
+{
+  p = skip_space(p, end);
+  if (p == end || !isdigit((unsigned char) *p))
+    throw runtime_error("Invalid PHYLIP header line (expected: <number of taxa> <number of sites>)");
+
+  value = 0;
+  while (p < end && isdigit((unsigned char) *p))
+    value = value * 10 + (*p++ - '0');
+
+  return p;
+}
+
+static const char * phylip_read_label(const char * p, const char * end, string& label)
+{
+  const auto& status = char_status();
+
+  p = skip_space(p, end);
+  if (p == end)
+    throw runtime_error("Unexpected end of file");
+
+  const char * begin = p;
+  while (p < end && status[*p] == CHAR_LEGAL)
+    ++p;
+
+  if (p < end && status[*p] != CHAR_SPACE)
+    throw runtime_error(illegal_char_error(*p, string(begin, p)));
+
+  label.assign(begin, p);
+
+  return p;
+}
+
 PhylipStream& operator>>(PhylipStream& stream, MSA& msa)
 {
-  pll_msa_t * pll_msa = pll_phylip_load(stream.fname().c_str(),
-                                        stream.interleaved() ? PLL_TRUE : PLL_FALSE);
+  MappedFile file(stream.fname(), MappedFile::Access::sequential);
+
+  const char * p = file.data();
+  const char * end = file.end();
 
-  if (pll_msa)
+  try
   {
-    msa = MSA(pll_msa);
-    pll_msa_destroy(pll_msa);
+    size_t taxa, sites;
+    p = phylip_read_uint(p, end, taxa);
+    p = phylip_read_uint(p, end, sites);
+
+    if (!taxa || !sites)
+      throw runtime_error("Number of taxa and sites must be positive");
+
+    /* rest of the header line is ignored */
+    p = line_end(p, end);
+
+    vector<string> labels(taxa);
+    vector<string> sequences(taxa, string(sites, '\0'));
+
+    if (stream.interleaved())
+    {
+      vector<size_t> lengths(taxa, 0);
+
+      /* first block: label followed by the first sequence chunk on the same line */
+      for (size_t i = 0; i < taxa; ++i)
+      {
+        p = phylip_read_label(p, end, labels[i]);
+        const char * eol = line_end(p, end);
+        lengths[i] = copy_seq_chars(p, eol, &sequences[i][0], 0, sites, labels[i]);
+        if (lengths[i] > sites)
+          throw runtime_error("Sequence is longer than specified in the header: " + labels[i]);
+        p = eol;
+      }
+
+      /* subsequent blocks: sequence chunks only, taxa in the same order */
+      while (std::any_of(lengths.cbegin(), lengths.cend(),
+                         [sites](size_t len) { return len < sites; }))
+      {
+        for (size_t i = 0; i < taxa; ++i)
+        {
+          p = skip_space(p, end);
+          if (p == end)
+            throw runtime_error("Unexpected end of file");
+
+          const char * eol = line_end(p, end);
+          lengths[i] = copy_seq_chars(p, eol, &sequences[i][0], lengths[i], sites, labels[i]);
+          if (lengths[i] > sites)
+            throw runtime_error("Sequence is longer than specified in the header: " + labels[i]);
+          p = eol;
+        }
+      }
+    }
+    else
+    {
+      const auto& status = char_status();
+      for (size_t i = 0; i < taxa; ++i)
+      {
+        p = phylip_read_label(p, end, labels[i]);
+
+        /* sequential format: sequence may span multiple lines */
+        char * out = &sequences[i][0];
+        size_t len = 0;
+        for (; len < sites && p < end; ++p)
+        {
+          const auto s = status[*p];
+          if (s == CHAR_LEGAL)
+            out[len++] = *p;
+          else if (s != CHAR_SPACE)
+            throw runtime_error(illegal_char_error(*p, labels[i]));
+        }
+
+        if (len < sites)
+          throw runtime_error("Unexpected end of file");
+
+        /* the rest of the line must be empty, otherwise the sequence is too long
+         * (and its tail would be taken for the next label) */
+        const char * eol = line_end(p, end);
+        if (skip_space(p, eol) != eol)
+          throw runtime_error("Sequence is longer than specified in the header: " + labels[i]);
+        p = eol;
+      }
+    }
+
+    msa = MSA(sites);
+    for (size_t i = 0; i < taxa; ++i)
+      msa.append(std::move(sequences[i]), labels[i]);
+  }
+  catch (runtime_error& e)
+  {
+    throw runtime_error("Unable to parse PHYLIP file: " +  stream.fname() + "\n" + e.what());
   }
-  else
-    libpll_check_error("Unable to parse PHYLIP file: " +  stream.fname() + "\n");
 
   return stream;
 }
@@ -178,19 +416,326 @@ PhylipStream& operator<<(PhylipStream& stream, const BootstrapMSA& bs_msa)
   return stream;
 }
 
+/* number of alignment patterns which are buffered column-wise before being transposed
+ * into per-taxon sequences */
+static const size_t VCF_BLOCK_PATTERNS = 4096;
+
+/* single-nucleotide allele -> upper-case base, or 0 for anything else (indels, '*', <NON_REF>) */
+static char vcf_snv_base(const char * begin, const char * end)
+{
+  if (end - begin != 1)
+    return 0;
+
+  const char c = toupper(*begin);
+  return (c == 'A' || c == 'C' || c == 'G' || c == 'T') ? c : 0;
+}
+
+/* unphased genotype -> IUPAC character, which is valid in both GT10 and DNA charmaps */
+static char vcf_genotype_char(char a1, char a2)
+{
+  if (a1 == a2)
+    return a1;
+
+  if (a1 > a2)
+    std::swap(a1, a2);
+
+  switch (a1)
+  {
+    case 'A':
+      return a2 == 'C' ? 'M' : (a2 == 'G' ? 'R' : 'W');
+    case 'C':
+      return a2 == 'G' ? 'S' : 'Y';
+    default:
+      return 'K';
+  }
+}
+
+/* parse GT value (e.g. 0/1, 1|1, ./., 0) and map it to an alignment character */
+static char vcf_gt_char(const char * p, const char * end, const string& alleles)
+{
+  char bases[2] = {0, 0};
+  size_t count = 0;
+  while (p < end && *p != ':')
+  {
+    if (*p == '.')
+      return '-';
+    else if (!isdigit((unsigned char) *p))
+      throw runtime_error("Invalid genotype (GT) field");
+
+    size_t idx = 0;
+    for (; p < end && isdigit((unsigned char) *p); ++p)
+      idx = idx * 10 + (*p - '0');
+
+    if (idx >= alleles.size())
+      throw runtime_error("Genotype refers to non-existing allele: " + to_string(idx));
+
+    const char base = alleles[idx];
+    if (count < 2)
+      bases[count] = base;
+    else if (base != bases[0] && base != bases[1])
+      return '-';      /* polyploid genotype with >2 distinct alleles */
+    count++;
+
+    if (p < end && (*p == '/' || *p == '|'))
+      ++p;
+  }
+
+  if (!count)
+    return '-';
+
+  return vcf_genotype_char(bases[0], count > 1 ? bases[1] : bases[0]);
+}
+
+VCFStream& operator>>(VCFStream& stream, MSA& msa)
+{
+  ifstream fs(stream.fname());
+  if (!fs)
+    throw runtime_error("Unable to open VCF file: " + stream.fname());
+
+  string line;
+  if (!getline(fs, line) || line.compare(0, 16, "##fileformat=VCF") != 0)
+    throw runtime_error("Invalid VCF file: first line must be ##fileformat=VCF...");
+
+  /* skip meta-information lines and read sample names from the header line */
+  NameList samples;
+  while (getline(fs, line))
+  {
+    if (line.compare(0, 2, "##") == 0)
+      continue;
+    else if (line.compare(0, 6, "#CHROM") == 0)
+    {
+      istringstream ss(line);
+      string token;
+      for (size_t col = 0; ss >> token; ++col)
+      {
+        if (col == 8 && token != "FORMAT")
+          throw runtime_error("Invalid VCF header line: FORMAT column expected");
+        else if (col > 8)
+          samples.push_back(token);
+      }
+      break;
+    }
+    else
+      throw runtime_error("Invalid VCF file: #CHROM header line not found");
+  }
+
+  const size_t taxa = samples.size();
+  if (!taxa)
+    throw runtime_error("VCF file does not contain any samples!");
+
+  LOG_DEBUG << "VCF: samples: " << taxa << endl;
+
+  /* unique patterns are stored in per-taxon sequences; new patterns are buffered
+   * column-wise and transposed in blocks */
+  vector<string> sequences(taxa);
+  string block;
+  block.reserve(VCF_BLOCK_PATTERNS * taxa);
+  size_t flushed = 0;
+
+  WeightVector weights;
+  unordered_map<uint64_t, uintVector> pattern_index;
+
+  auto flush_block = [&]()
+    {
+      const size_t block_size = block.size() / taxa;
+      for (size_t i = 0; i < taxa; ++i)
+      {
+        auto& seq = sequences[i];
+        seq.resize(flushed + block_size);
+        for (size_t k = 0; k < block_size; ++k)
+          seq[flushed + k] = block[k * taxa + i];
+      }
+      flushed += block_size;
+      block.clear();
+    };
+
+  auto pattern_equal = [&](size_t k, const string& col) -> bool
+    {
+      if (k >= flushed)
+        return block.compare((k - flushed) * taxa, taxa, col) == 0;
+
+      for (size_t i = 0; i < taxa; ++i)
+      {
+        if (sequences[i][k] != col[i])
+          return false;
+      }
+      return true;
+    };
+
+  string col(taxa, 0);
+  string alleles;
+  vector<const char *> fields;
+  size_t num_records = 0, num_skipped = 0, line_num = 0;
+  while (getline(fs, line))
+  {
+    line_num++;
+    if (!line.empty() && line.back() == '\r')
+      line.pop_back();
+    if (line.empty())
+      continue;
+
+    /* split record into tab-separated fields (without copying) */
+    fields.clear();
+    const char * p = line.c_str();
+    const char * end = p + line.size();
+    fields.push_back(p);
+    while ((p = (const char *) memchr(p, '\t', end - p)) != nullptr)
+      fields.push_back(++p);
+    fields.push_back(end + 1);
+
+    try
+    {
+      if (fields.size() - 1 != taxa + 9)
+        throw runtime_error("Wrong number of columns");
+
+      /* GT must be the first key, and not merely a prefix of another key (e.g. GTX) */
+      const char * format_end = fields[9] - 1;
+      if (format_end - fields[8] < 2 || strncmp(fields[8], "GT", 2) != 0 ||
+          (format_end - fields[8] > 2 && fields[8][2] != ':'))
+      {
+        throw runtime_error("GT must be the first FORMAT field");
+      }
+
+      /* collect REF and ALT alleles, skip anything but single-nucleotide variants */
+      alleles.clear();
+      alleles += vcf_snv_base(fields[3], fields[4] - 1);
+      const char * alt = fields[4];
+      const char * alt_end = fields[5] - 1;
+      if (!(alt_end - alt == 1 && *alt == '.'))
+      {
+        while (alt < alt_end)
+        {
+          auto comma = (const char *) memchr(alt, ',', alt_end - alt);
+          const char * allele_end = comma ? comma : alt_end;
+          alleles += vcf_snv_base(alt, allele_end);
+          alt = allele_end + 1;
+        }
+      }
+
+      if (alleles.find('\0') != string::npos)
+      {
+        num_skipped++;
+        continue;
+      }
+
+      for (size_t i = 0; i < taxa; ++i)
+        col[i] = vcf_gt_char(fields[9 + i], fields[10 + i] - 1, alleles);
+    }
+    catch (runtime_error& e)
+    {
+      throw runtime_error("Error parsing VCF record at line " + to_string(line_num) +
+                          " (after header): " + e.what());
+    }
+
+    num_records++;
+
+    /* on-the-fly pattern compression: only unique patterns are stored */
+    uint64_t h = 14695981039346656037ULL;
+    for (auto c: col)
+      h = (h ^ (unsigned char) c) * 1099511628211ULL;
+
+    auto& ids = pattern_index[h];
+    auto pat = std::find_if(ids.cbegin(), ids.cend(),
+                            [&](unsigned int k) { return pattern_equal(k, col); });
+    if (pat != ids.cend())
+      weights[*pat]++;
+    else
+    {
+      ids.push_back(weights.size());
+      weights.push_back(1);
+      block.append(col);
+      if (block.size() == VCF_BLOCK_PATTERNS * taxa)
+        flush_block();
+    }
+  }
+
+  flush_block();
+
+  LOG_DEBUG << "VCF: variants: " << num_records << ", unique patterns: " << weights.size()
+            << ", skipped non-SNV records: " << num_skipped << endl;
+
+  if (!num_records)
+    throw runtime_error("VCF file does not contain any single-nucleotide variants!");
+
+  msa = MSA(num_records);
+  for (size_t i = 0; i < taxa; ++i)
+    msa.append(std::move(sequences[i]), samples[i]);
+
+  msa.weights(std::move(weights));
+
+  return stream;
+}
+
+/* parse a decimal floating point number from [p, end); numbers with up to 15 significant
+ * digits and a small decimal exponent are converted exactly without strtod() */
+static const char * parse_double(const char * p, const char * end, double& value)
+{
+  static const double pow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+                                  1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19,
+                                  1e20, 1e21, 1e22 };
+  const char * start = p;
+
+  uint64_t mantissa = 0;
+  int digits = 0;
+  int frac_digits = 0;
+  for (; p < end && isdigit((unsigned char) *p); ++p, ++digits)
+    mantissa = mantissa * 10 + (*p - '0');
+  if (p < end && *p == '.')
+  {
+    for (++p; p < end && isdigit((unsigned char) *p); ++p, ++digits, ++frac_digits)
+      mantissa = mantissa * 10 + (*p - '0');
+  }
+
+  const bool simple = digits > 0 && (p == end || (*p != 'e' && *p != 'E'));
+  if (simple && digits <= 15 && frac_digits <= 22)
+  {
+    /* both operands are exact, hence the result is correctly rounded (same as strtod) */
+    value = (double) mantissa / pow10[frac_digits];
+    return p;
+  }
+
+  /* general case: sign, exponent, long mantissa etc. */
+  char buf[64];
+  const size_t len = std::min<size_t>(sizeof(buf) - 1, end - start);
+  memcpy(buf, start, len);
+  buf[len] = 0;
+  char * num_end;
+  value = strtod(buf, &num_end);
+  if (num_end == buf)
+    throw runtime_error("Invalid number: " + string(start, std::min<size_t>(end - start, 20)));
+
+  return start + (num_end - buf);
+}
+
+/* skip spaces and tabs, but not line breaks */
+static inline const char * skip_blank(const char * p, const char * end)
+{
+  while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+    ++p;
+  return p;
+}
+
+static inline bool blank_line(const char * p, const char * end)
+{
+  p = skip_blank(p, end);
+  return p == end || *p == '\n';
+}
+
 CATGStream& operator>>(CATGStream& stream, MSA& msa)
 {
-  ifstream fs;
-  fs.open(stream.fname());
+  MappedFile file(stream.fname(), MappedFile::Access::sequential);
 
-  /* read alignment dimensions */
-  size_t taxa_count, site_count;
+  const char * p = file.data();
+  const char * end = file.end();
 
+  /* read alignment dimensions */
+  size_t taxa_count = 0, site_count = 0;
   try
   {
-    fs >> taxa_count >> site_count;
+    p = phylip_read_uint(p, end, taxa_count);
+    p = phylip_read_uint(p, end, site_count);
   }
-  catch(exception& e)
+  catch (exception& e)
   {
     LOG_DEBUG << e.what() << endl;
     taxa_count = site_count = 0;
@@ -201,92 +746,257 @@ CATGStream& operator>>(CATGStream& stream, MSA& msa)
 
   LOG_DEBUG << "CATG: taxa: " << taxa_count << ", sites: " << site_count << endl;
 
-  string dummy(site_count, '*');
-
   /* read taxa names */
-  try
+  msa = MSA(site_count);
   {
+    string dummy(site_count, '*');
     string taxon_name;
     for (size_t i = 0; i < taxa_count; ++i)
     {
-      fs >> taxon_name;
+      p = skip_space(p, end);
+      if (p == end)
+        break;
+      const char * name_end = p;
+      while (name_end < end && !isspace(*name_end))
+        ++name_end;
+      taxon_name.assign(p, name_end);
+      p = name_end;
+
       msa.append(dummy, taxon_name);
-      LOG_DEBUG << "CATG: taxon " << i << ": " << taxon_name << endl;
     }
   }
-  catch (exception& e)
-  {
-    LOG_DEBUG << e.what() << endl;
-  }
 
   if (msa.size() != taxa_count)
     throw runtime_error("Wrong number of taxon labels!");
 
+  p = line_end(p, end);
+
+  /* every site is stored on a separate line: index non-blank lines in parallel */
+  const size_t data_size = end - p;
+  const auto num_threads = (unsigned int) std::min<size_t>(stream.num_threads(),
+                                                           data_size / MSA_PARSE_MIN_CHUNK + 1);
+  const char * data_start = p;
+  vector<vector<const char *>> block_lines(num_threads);
+  parallel_blocks(data_size, num_threads,
+                  [&](size_t t, size_t begin, size_t block_end)
+                  {
+                    auto& lines = block_lines[t];
+                    const char * q = data_start + begin;
+                    const char * q_end = data_start + block_end;
+                    while ((q = (const char *) memchr(q, '\n', q_end - q)) != nullptr)
+                    {
+                      ++q;
+                      if (!blank_line(q, end))
+                        lines.push_back(q);
+                    }
+                  });
+
+  vector<const char *> lines;
+  for (const auto& l: block_lines)
+    lines.insert(lines.end(), l.cbegin(), l.cend());
+  block_lines.clear();
+
+  if (lines.size() != site_count)
+  {
+    throw runtime_error("Wrong number of sites: expected " + to_string(site_count) +
+                        ", found " + to_string(lines.size()) + "!");
+  }
+
+  /* number of states is determined by the first probability vector */
+  {
+    const char * q = skip_blank(lines[0], end);
+    while (q < end && !isspace(*q))
+      ++q;
+    q = skip_blank(q, end);
+    size_t states = 1;
+    for (; q < end && !isspace(*q); ++q)
+      states += (*q == ',');
+
+    msa.states(states, stream.single_precision());
+
+    LOG_DEBUG << "CATG: number of states: " << states << endl;
+  }
+
   /* this is mapping for DNA: CATG -> ACGT, for other datatypes we assume 1:1 mapping */
+  const auto states = msa.states();
+  auto& probs = msa.probs();
   std::vector<size_t> state_map({1, 0, 3, 2});
+  if (states != 4)
+  {
+    state_map.resize(states);
+    for (size_t k = 0; k < states; ++k)
+      state_map[k] = k;
+  }
 
-  string cons_str, prob_str;
+  /* read alignment, remember that the matrix is transposed! every thread fills a block of
+   * sites, which is a contiguous segment of each taxon's sequence and probability vector */
+  parallel_blocks(site_count, num_threads,
+                  [&](size_t, size_t begin, size_t block_end)
+                  {
+                    for (size_t i = begin; i < block_end; ++i)
+                    {
+                      const char * q = skip_blank(lines[i], end);
+                      const char * eol = line_end(q, end);
+
+                      /* read consensus sequences */
+                      const char * cons = q;
+                      while (q < eol && !isspace(*q))
+                        ++q;
+
+                      if ((size_t) (q - cons) != taxa_count)
+                      {
+                        throw runtime_error("Wrong length of consensus sequence for site " +
+                                            to_string(i+1) + "!");
+                      }
+
+                      for (size_t j = 0; j < taxa_count; ++j)
+                      {
+                        msa[j][i] = cons[j];
+
+                        q = skip_blank(q, eol);
+                        size_t k = 0;
+                        while (q < eol && !isspace(*q))
+                        {
+                          double v;
+                          q = parse_double(q, eol, v);
+                          if (k < states)
+                            probs.set(j, i, state_map[k], v);
+                          ++k;
+                          if (q < eol && *q == ',')
+                            ++q;
+                          else if (q < eol && !isspace(*q))
+                          {
+                            throw runtime_error("Invalid state probability for site " +
+                                                to_string(i+1) + "!");
+                          }
+                        }
+
+                        if (k != states)
+                        {
+                          throw runtime_error("Wrong number of state probabilities for site " +
+                                              to_string(i+1) + "!");
+                        }
+                      }
+                    }
+                  });
 
-  /* read alignment, remember that the matrix is transposed! */
-  for (size_t i = 0; i < msa.num_sites(); ++i)
+#ifdef CATG_DEBUG
   {
-    /* read consensus sequences */
-    fs >> cons_str;
+    PhylipStream ps("catgout.phy");
+    ps << msa;
+  }
+#endif
 
-    LOG_DEBUG << "CATG: site " << i << " consesus seq: " << cons_str << endl;
+  return stream;
+}
 
-    if (cons_str.length() != msa.size())
-      throw runtime_error("Wrong length of consensus sequence for site " + to_string(i+1) + "!");
+/* number of bytes examined by the MSA format sniffer */
+static const size_t MSA_SNIFF_BYTES = 4096;
 
-    std::vector<double> probs;
+static bool is_uint_token(const string& token)
+{
+  return !token.empty() && std::all_of(token.cbegin(), token.cend(),
+                                       [](char c) { return isdigit((unsigned char) c); });
+}
 
-    for (size_t j = 0; j < msa.size(); ++j)
-    {
-      msa[j][i] = cons_str[j];
+/* CATG site records contain comma-separated state probabilities, e.g. 0.1,0.2,0.3,0.4 */
+static bool is_prob_vector_token(const string& token)
+{
+  return token.find(',') != string::npos &&
+      std::any_of(token.cbegin(), token.cend(), [](char c) { return isdigit((unsigned char) c); }) &&
+      std::all_of(token.cbegin(), token.cend(),
+                  [](char c) { return isdigit((unsigned char) c) || strchr(".,eE+-", c); });
+}
 
-      fs >> prob_str;
+std::vector<FileFormat> msa_sniff_format(const std::string& filename)
+{
+  if (RBAStream::rba_file(filename))
+    return {FileFormat::binary};
 
-      if (msa.states() == 0)
-      {
-        auto states = std::count_if(prob_str.cbegin(), prob_str.cend(),
-                                    [](char c) -> bool { return c == ','; }) + 1;
-        msa.states(states);
+  string buf(MSA_SNIFF_BYTES, '\0');
+  {
+    ifstream fs(filename, ios::binary);
+    fs.read(&buf[0], buf.size());
+    buf.resize(fs.gcount());
+  }
 
-        /* see above: for datatypes other than DNA we assume 1:1 mapping */
-        if (states != 4)
-          state_map.clear();
+  /* skip UTF-8 BOM and leading whitespace */
+  size_t pos = buf.compare(0, 3, "\xEF\xBB\xBF") == 0 ? 3 : 0;
+  pos = buf.find_first_not_of(" \t\r\n", pos);
+  if (pos == string::npos)
+    return {};
 
-        LOG_DEBUG << "CATG: number of states: " << states << endl;
-      }
+  if (buf[pos] == '>')
+    return {FileFormat::fasta};
 
-      auto site_probs = msa.probs(j, i);
+  if (buf.compare(pos, 16, "##fileformat=VCF") == 0)
+    return {FileFormat::vcf};
 
-      istringstream ss(prob_str);
-      size_t k = 0;
-      for (string token; getline(ss, token, ','); ++k)
-      {
-        if (state_map.empty())
-          site_probs[k] = stod(token);
-        else
-          site_probs[state_map[k]] = stod(token);
-      }
+  /* PHYLIP and CATG both start with the alignment dimensions: <taxa> <sites> */
+  istringstream ss(buf.substr(pos));
+  string line;
+  getline(ss, line);
 
-      if (k != msa.states())
-        throw runtime_error("Wrong number of state probabilities for site " + to_string(i+1) + "!");
-    }
+  string ntaxa, nsites;
+  istringstream(line) >> ntaxa >> nsites;
+  if (!is_uint_token(ntaxa) || !is_uint_token(nsites))
+    return {};
+
+  /* look at the first few data lines, ignoring a possibly truncated last one */
+  for (string token; ss >> token && !ss.eof(); )
+  {
+    if (is_prob_vector_token(token))
+      return {FileFormat::catg};
   }
 
-#ifdef CATG_DEBUG
+  /* PHYLIP: count the residues of the first record as if the file was sequential. In a
+   * sequential file, the record ends exactly at a line break. In an interleaved file, the
+   * labels of the following taxa make the count overshoot, or a blank line ends the block */
+  const bool truncated = buf.size() == MSA_SNIFF_BYTES;
+  const auto site_count = strtoull(nsites.c_str(), nullptr, 10);
+  istringstream ls(buf.substr(pos));
+  getline(ls, line);
+  size_t residues = 0;
+  bool first = true;
+  while (getline(ls, line))
   {
-    PhylipStream ps("catgout.phy");
-    ps << msa;
+    const bool partial = truncated && ls.eof();
+
+    if (line.find_first_not_of(" \t\r") == string::npos)
+    {
+      if (first)
+        continue;
+      return {FileFormat::iphylip};
+    }
+
+    istringstream ts(line);
+    string token;
+    if (first)
+      ts >> token;
+    while (ts >> token)
+      residues += token.size();
+
+    if (residues > site_count)
+      return {FileFormat::iphylip};
+    else if (partial)
+    {
+      /* first line does not fit into the buffer -> most likely sequential */
+      if (first)
+        return {FileFormat::phylip, FileFormat::iphylip};
+      break;
+    }
+    else if (residues == site_count)
+      return {FileFormat::phylip};
+
+    first = false;
   }
-#endif
 
-  return stream;
+  /* first record is longer than the buffer: can't tell */
+  return {FileFormat::iphylip, FileFormat::phylip};
 }
 
-MSA msa_load_from_file(const std::string &filename, const FileFormat format)
+MSA msa_load_from_file(const std::string &filename, const FileFormat format,
+                        unsigned int num_threads, bool prob_single_precision)
 {
   MSA msa;
 
@@ -299,22 +1009,44 @@ MSA msa_load_from_file(const std::string &filename, const FileFormat format)
                                                 {FileFormat::vcf, "VCF"},
                                                 {FileFormat::binary, "RAxML-binary"} };
 
-  auto fmt_begin = msa_formats.cbegin();
-  auto fmt_end = msa_formats.cend();
-
   if (!sysutil_file_exists(filename))
     throw runtime_error("File not found: " + filename);
 
+  auto find_format = [](FileFormat f)
+    {
+      auto it = std::find_if(msa_formats.cbegin(), msa_formats.cend(),
+                             [f](const FormatNamePair& p) { return p.first == f; });
+      assert(it != msa_formats.cend());
+      return *it;
+    };
+
+  vector<FormatNamePair> try_formats;
+  size_t sniffed_count = 0;
   if (format != FileFormat::autodetect)
+    try_formats.push_back(find_format(format));
+  else
   {
-    fmt_begin = std::find_if(msa_formats.begin(), msa_formats.end(),
-                             [format](const FormatNamePair& p) { return p.first == format; });
-    assert(fmt_begin != msa_formats.cend());
-    fmt_end = fmt_begin + 1;
+    /* formats suggested by the sniffer go first, full list is only a last resort */
+    for (auto f: msa_sniff_format(filename))
+      try_formats.push_back(find_format(f));
+
+    sniffed_count = try_formats.size();
+
+    for (const auto& p: msa_formats)
+    {
+      if (std::find(try_formats.cbegin(), try_formats.cend(), p) == try_formats.cend())
+        try_formats.push_back(p);
+    }
   }
 
-  for (; fmt_begin != fmt_end; fmt_begin++)
+  for (auto fmt_begin = try_formats.cbegin(); fmt_begin != try_formats.cend(); fmt_begin++)
   {
+    if (sniffed_count > 0 && fmt_begin == try_formats.cbegin() + sniffed_count)
+    {
+      LOG_DEBUG << "Failed to load MSA in the detected format, trying all supported formats..."
+                << endl;
+    }
+
     try
     {
       switch (fmt_begin->first)
@@ -322,6 +1054,7 @@ MSA msa_load_from_file(const std::string &filename, const FileFormat format)
         case FileFormat::fasta:
         {
           FastaStream s(filename);
+          s.num_threads(num_threads);
           s >> msa;
           return msa;
           break;
@@ -329,6 +1062,7 @@ MSA msa_load_from_file(const std::string &filename, const FileFormat format)
         case FileFormat::fasta_longlabels:
         {
           FastaStream s(filename, true);
+          s.num_threads(num_threads);
           s >> msa;
           return msa;
           break;
@@ -336,6 +1070,7 @@ MSA msa_load_from_file(const std::string &filename, const FileFormat format)
         case FileFormat::iphylip:
         {
           PhylipStream s(filename, true);
+          s.num_threads(num_threads);
           s >> msa;
           return msa;
           break;
@@ -343,6 +1078,14 @@ MSA msa_load_from_file(const std::string &filename, const FileFormat format)
         case FileFormat::phylip:
         {
           PhylipStream s(filename, false);
+          s.num_threads(num_threads);
+          s >> msa;
+          return msa;
+          break;
+        }
+        case FileFormat::vcf:
+        {
+          VCFStream s(filename);
           s >> msa;
           return msa;
           break;
@@ -350,6 +1093,8 @@ MSA msa_load_from_file(const std::string &filename, const FileFormat format)
         case FileFormat::catg:
         {
           CATGStream s(filename);
+          s.num_threads(num_threads);
+          s.single_precision(prob_single_precision);
           s >> msa;
           return msa;
           break;
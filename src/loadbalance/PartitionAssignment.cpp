@@ -1,3 +1,5 @@
+#include <unordered_map>
+
 #include "PartitionAssignment.hpp"
 
 PartitionAssignmentStats::PartitionAssignmentStats(const PartitionAssignmentList& part_assign)
@@ -20,6 +22,37 @@ PartitionAssignmentStats::PartitionAssignmentStats(const PartitionAssignmentList
     total_weight += pa.weight();
     total_parts += pa.num_parts();
   }
+
+  /* partition is split if its sites are distributed among multiple threads */
+  std::unordered_map<size_t, size_t> part_thread_count;
+  for (const auto& pa: part_assign)
+  {
+    for (const auto& range: pa)
+      part_thread_count[range.part_id]++;
+  }
+
+  total_split_parts = max_thread_split_parts = 0;
+  min_thread_split_parts = std::numeric_limits<size_t>::max();
+  for (const auto& e: part_thread_count)
+  {
+    if (e.second > 1)
+      total_split_parts++;
+  }
+
+  for (const auto& pa: part_assign)
+  {
+    size_t split_parts = 0;
+    for (const auto& range: pa)
+    {
+      if (part_thread_count[range.part_id] > 1)
+        split_parts++;
+    }
+    min_thread_split_parts = std::min(min_thread_split_parts, split_parts);
+    max_thread_split_parts = std::max(max_thread_split_parts, split_parts);
+  }
+
+  if (part_assign.empty())
+    min_thread_split_parts = 0;
 }
 
 std::ostream& operator<<(std::ostream& stream, const PartitionAssignment& pa)
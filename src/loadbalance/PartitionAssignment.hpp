@@ -74,6 +74,9 @@ struct PartitionAssignmentStats
   size_t max_thread_sites;
   double min_thread_weight;
   double max_thread_weight;
+  size_t total_split_parts;       /* partitions distributed over >1 threads */
+  size_t min_thread_split_parts;
+  size_t max_thread_split_parts;
 };
 
 std::ostream& operator<<(std::ostream& stream, const PartitionAssignment& pa);
@@ -21,6 +21,8 @@
 #include <algorithm>
 #include <chrono>
 #include <cstdint>
+#include <numeric>
+#include <random>
 
 #include <memory>
 
@@ -74,6 +76,8 @@ struct RaxmlInstance
   shared_ptr<ConsensusTree> consens_tree;
 
   TreeList start_trees;
+  doubleVector triage_scores;
+  IDVector triage_trees;
   BootstrapReplicateList bs_reps;
   TreeList bs_start_trees;
 
@@ -213,6 +217,7 @@ void init_part_info(RaxmlInstance& instance)
 
     auto rba_elem = opts.use_rba_partload ? RBAStream::RBAElement::metadata : RBAStream::RBAElement::all;
     RBAStream bs(opts.msa_file);
+    bs.use_mmap(opts.use_rba_mmap);
     bs >> RBAStream::RBAOutput(parted_msa, rba_elem, nullptr);
 
     // binary probMSAs are not supported yet
@@ -321,48 +326,84 @@ bool check_msa_global(const MSA& msa)
     msa_valid = false;
   }
 
-  /* check for duplicate taxon names */
-  unsigned long stats_mask = PLLMOD_MSA_STATS_DUP_TAXA;
-
-  pllmod_msa_stats_t * stats = pllmod_msa_compute_stats(msa.pll_msa(),
-                                                        4,
-                                                        pll_map_nt, // map is not used here
-                                                        NULL,
-                                                        stats_mask);
-
-  libpll_check_error("ERROR computing MSA stats");
-  assert(stats);
+  /* check for duplicate taxon names: done on labels only, since building
+   * pll_msa for the full alignment would double the memory footprint */
+  IdPairVector dup_taxa;
+  {
+    unordered_map<string, size_t> first_id;
+    for (size_t i = 0; i < msa.size(); ++i)
+    {
+      auto res = first_id.emplace(msa.label(i), i);
+      if (!res.second)
+        dup_taxa.emplace_back(res.first->second, i);
+    }
+  }
 
-  if (stats->dup_taxa_pairs_count > 0)
+  if (!dup_taxa.empty())
   {
     LOG_ERROR << endl;
-    for (unsigned long c = 0; c < stats->dup_taxa_pairs_count; ++c)
+    for (const auto& p: dup_taxa)
     {
-      auto id1 = stats->dup_taxa_pairs[c*2];
-      auto id2 = stats->dup_taxa_pairs[c*2+1];
-      LOG_ERROR << "ERROR: Sequences " << id1+1 << " and "
-                << id2+1 << " have identical name: "
-                << msa.label(id1) << endl;
+      LOG_ERROR << "ERROR: Sequences " << p.first+1 << " and "
+                << p.second+1 << " have identical name: "
+                << msa.label(p.first) << endl;
     }
     LOG_ERROR << "\nERROR: Duplicate sequence names found: "
-              << stats->dup_taxa_pairs_count << endl;
+              << dup_taxa.size() << endl;
 
     msa_valid = false;
   }
 
-  pllmod_msa_destroy_stats(stats);
-
   return msa_valid;
 }
 
+/* find pairs (first occurrence, duplicate) of sequences which are identical in all partitions */
+IdPairVector find_duplicate_seqs(const PartitionedMSA& parted_msa)
+{
+  const auto taxa = parted_msa.taxon_count();
+
+  /* combine per-partition sequence hashes */
+  std::hash<string> hasher;
+  vector<size_t> seq_hash(taxa, 0);
+  for (const auto& pinfo: parted_msa.part_list())
+  {
+    const auto& msa = pinfo.msa();
+    for (size_t i = 0; i < taxa; ++i)
+      seq_hash[i] ^= hasher(msa[i]) + 0x9e3779b9 + (seq_hash[i] << 6) + (seq_hash[i] >> 2);
+  }
+
+  auto identical = [&parted_msa](size_t i, size_t j) -> bool
+    {
+      for (const auto& pinfo: parted_msa.part_list())
+      {
+        if (pinfo.msa()[i] != pinfo.msa()[j])
+          return false;
+      }
+      return true;
+    };
+
+  IdPairVector dup_seqs;
+  unordered_map<size_t, IDVector> unique_seqs;
+  for (size_t i = 0; i < taxa; ++i)
+  {
+    auto& bucket = unique_seqs[seq_hash[i]];
+    auto orig = std::find_if(bucket.cbegin(), bucket.cend(),
+                             [&identical, i](size_t j) { return identical(j, i); });
+    if (orig != bucket.cend())
+      dup_seqs.emplace_back(*orig, i);
+    else
+      bucket.push_back(i);
+  }
+
+  return dup_seqs;
+}
+
 bool check_msa(RaxmlInstance& instance)
 {
   LOG_VERB_TS << "Checking the alignment...\n";
 
   const auto& opts = instance.opts;
   auto& parted_msa = *instance.parted_msa;
-  const auto& full_msa = parted_msa.full_msa();
-  const auto pll_msa = full_msa.pll_msa();
 
   bool msa_valid = true;
   bool msa_corrected = false;
@@ -394,24 +435,7 @@ bool check_msa(RaxmlInstance& instance)
   /* check for duplicate sequences */
   if (opts.safety_checks.isset(SafetyCheck::msa_dups))
   {
-    unsigned long stats_mask = PLLMOD_MSA_STATS_DUP_SEQS;
-
-    pllmod_msa_stats_t * stats = pllmod_msa_compute_stats(pll_msa,
-                                                          4,
-                                                          pll_map_nt, // map is not used here
-                                                          NULL,
-                                                          stats_mask);
-
-    libpll_check_error("ERROR computing MSA stats");
-    assert(stats);
-
-    for (unsigned long c = 0; c < stats->dup_seqs_pairs_count; ++c)
-    {
-      dup_seqs.emplace_back(stats->dup_seqs_pairs[c*2],
-                            stats->dup_seqs_pairs[c*2+1]);
-    }
-
-    pllmod_msa_destroy_stats(stats);
+    dup_seqs = find_duplicate_seqs(parted_msa);
   }
 
   size_t total_gap_cols = 0;
@@ -806,6 +830,22 @@ void check_options_early(Options& opts)
       throw runtime_error("Custom site weights are not supported in per-site likelihood computation mode!");
   }
 
+  if (opts.use_spr_taxpar)
+  {
+    if (opts.brlen_linkage == PLLMOD_COMMON_BRLEN_UNLINKED)
+      throw runtime_error("Taxon-parallel SPR mode is not supported with unlinked branch lengths!");
+    if (!opts.constraint_tree_file.empty())
+      throw runtime_error("Taxon-parallel SPR mode is not supported with topological constraints!");
+  }
+
+  if (opts.use_search_coop)
+  {
+    if (opts.brlen_linkage == PLLMOD_COMMON_BRLEN_UNLINKED)
+      throw runtime_error("Cooperative tree search is not supported with unlinked branch lengths!");
+    if (!opts.constraint_tree_file.empty())
+      throw runtime_error("Cooperative tree search is not supported with topological constraints!");
+  }
+
   /* autodetect if we can use partial RBA loading */
   opts.use_rba_partload &= (opts.num_ranks > 1 && !opts.coarse());                // only useful for fine-grain MPI runs
   opts.use_rba_partload &= (!opts.start_trees.count(StartingTree::parsimony));    // does not work with parsimony
@@ -842,7 +882,7 @@ void check_options(RaxmlInstance& instance)
   }
 
   /* check that we have enough patterns per thread */
-  if (opts.safety_checks.isset(SafetyCheck::perf_threads))
+  if (opts.safety_checks.isset(SafetyCheck::perf_threads) && !opts.use_spr_taxpar)
   {
     if (ParallelContext::master_rank() && ParallelContext::num_procs() > 1)
     {
@@ -873,6 +913,28 @@ void check_options(RaxmlInstance& instance)
     }
   }
 
+  /* re-resolving collapsed branches could violate the constraint -> skip this stage */
+  if (opts.pars_collapse_iters > 0 && !opts.constraint_tree_file.empty() &&
+      opts.start_trees.count(StartingTree::parsimony))
+  {
+    LOG_WARN << endl;
+    LOG_WARN << "WARNING: Parsimony starting tree improvement (--pars-collapse) is not supported "
+        "with topological constraints and will be skipped!" << endl << endl;
+  }
+
+  /* wall-clock limit makes the number of collapse-and-resolve iterations machine-dependent */
+  if (opts.pars_collapse_iters > 0 && opts.pars_collapse_seconds > 0. &&
+      opts.start_trees.count(StartingTree::parsimony))
+  {
+    LOG_WARN << endl;
+    LOG_WARN << "WARNING: Parsimony starting tree improvement is limited to "
+             << opts.pars_collapse_seconds << " seconds per tree." << endl;
+    LOG_WARN << "NOTE:    Resulting starting trees (and thus final results) depend on the machine "
+        "load and are NOT reproducible with the same random seed!" << endl;
+    LOG_WARN << "NOTE:    Omit the time limit (--pars-collapse " << opts.pars_collapse_iters
+             << ") to get reproducible results." << endl << endl;
+  }
+
   /* auto-enable rate scalers for >2000 taxa */
   if (opts.safety_checks.isset(SafetyCheck::model_rate_scalers))
   {
@@ -1050,6 +1112,12 @@ void load_msa_weights(MSA& msa, const Options& opts)
   }
 }
 
+/* number of helper threads for alignment parsing and preprocessing */
+unsigned int load_threads(const Options& opts)
+{
+  return opts.num_threads > 0 ? opts.num_threads : opts.num_threads_max;
+}
+
 void load_msa(RaxmlInstance& instance)
 {
   const auto& opts = instance.opts;
@@ -1058,7 +1126,8 @@ void load_msa(RaxmlInstance& instance)
   LOG_INFO_TS << "Reading alignment from file: " << opts.msa_file << endl;
 
   /* load MSA */
-  auto msa = msa_load_from_file(opts.msa_file, opts.msa_format);
+  auto msa = msa_load_from_file(opts.msa_file, opts.msa_format, load_threads(opts),
+                                opts.use_prob_msa_float);
 
   if (!msa.size())
     throw runtime_error("Alignment file is empty!");
@@ -1068,7 +1137,10 @@ void load_msa(RaxmlInstance& instance)
 
   if (msa.probabilistic() && opts.use_prob_msa)
   {
-    instance.opts.use_pattern_compression = false;
+    LOG_VERB << "State probabilities: " << msa.probs().mem_size() / (1024 * 1024) << " MB ("
+             << (msa.probs().single_precision() ? "single" : "double") << " precision)" << endl;
+
+    /* NB: pattern compression is fine, identical probability columns are merged */
     instance.opts.use_tip_inner = false;
     instance.opts.use_repeats = false;
 
@@ -1076,11 +1148,28 @@ void load_msa(RaxmlInstance& instance)
       throw runtime_error("Partitioned probabilistic alignments are not supported yet, sorry...");
   }
   else
+  {
     instance.opts.use_prob_msa = false;
 
+    /* probabilities are not used -> drop them, such that pattern compression only considers
+     * characters (otherwise, sites with identical characters would not be merged) */
+    if (msa.probabilistic())
+      msa.states(0);
+  }
+
   if (!check_msa_global(msa))
     throw runtime_error("Alignment check failed (see details above)!");
 
+  /* VCF reader stores unique patterns only, original site order is lost */
+  if (!msa.weights().empty())
+  {
+    if (parted_msa.part_count() > 1)
+      throw runtime_error("Partitioned VCF alignments are not supported!");
+
+    if (!opts.weights_file.empty())
+      throw runtime_error("Site weights file cannot be used with VCF alignments!");
+  }
+
   load_msa_weights(msa, opts);
 
   parted_msa.full_msa(std::move(msa));
@@ -1097,12 +1186,7 @@ void load_msa(RaxmlInstance& instance)
   {
     LOG_VERB_TS << "Compressing alignment patterns... " << endl;
     bool store_backmap = opts.command == Command::sitelh;
-    parted_msa.compress_patterns(store_backmap);
-
-    // temp workaround: since MSA pattern compression calls rand(), it will change all random
-    // numbers generated afterwards. so just reset seed to the initial value to ensure that
-    // starting trees, BS replicates etc. are the same regardless whether pat.comp is ON or OFF
-    srand(opts.random_seed);
+    parted_msa.compress_patterns(store_backmap, load_threads(opts));
   }
 
 //  if (parted_msa.part_count() > 1)
@@ -1134,6 +1218,7 @@ void load_msa(RaxmlInstance& instance)
     else if (opts.command != Command::check)
     {
       RBAStream bs(binary_msa_fname);
+      bs.compress(opts.use_rba_compression);
       bs << parted_msa;
       LOG_INFO << "NOTE: Binary MSA file created: " << binary_msa_fname << endl << endl;
     }
@@ -1164,7 +1249,18 @@ void prepare_tree(const RaxmlInstance& instance, Tree& tree)
   tree.reset_tip_ids(instance.tip_id_map);
 }
 
-Tree generate_tree(const RaxmlInstance& instance, StartingTree type, int random_seed)
+unsigned int parsimony_attributes(const Options& opts)
+{
+  unsigned int attrs = opts.simd_arch;
+
+  // TODO: check if there is any reason not to use tip-inner
+  attrs |= PLL_ATTRIB_PATTERN_TIP;
+
+  return attrs;
+}
+
+Tree generate_tree(const RaxmlInstance& instance, StartingTree type, int random_seed,
+                   const BootstrapReplicate * bs_rep = nullptr)
 {
   Tree tree;
 
@@ -1213,13 +1309,33 @@ Tree generate_tree(const RaxmlInstance& instance, StartingTree type, int random_
     {
       unsigned int score;
 
-      const ParsimonyMSA& pars_msa = *instance.parted_msa_parsimony.get();
+      /* bootstrap replicate: build parsimony tree on the reweighted alignment */
+      unique_ptr<ParsimonyMSA> bs_pars_msa;
+      if (bs_rep)
+      {
+        bs_pars_msa.reset(new ParsimonyMSA(instance.parted_msa, bs_rep->site_weights,
+                                           parsimony_attributes(opts)));
+      }
+
+      const ParsimonyMSA& pars_msa = bs_pars_msa ? *bs_pars_msa : *instance.parted_msa_parsimony.get();
       tree = Tree::buildParsimonyConstrained(pars_msa, random_seed, &score,
                                              instance.constraint_tree, instance.tip_msa_idmap);
 
-      LOG_WORKER_TS(LogLevel::verbose) << "Generated a PARSIMONY starting tree, seed: " << random_seed <<
+      LOG_WORKER_TS(LogLevel::verbose) << "Generated a PARSIMONY starting tree" <<
+          (bs_rep ? " on bootstrap replicate" : "") << ", seed: " << random_seed <<
           ", score: " << score << endl;
 
+      /* ML starting trees only: bootstrap replicate trees are not improved. Also skipped with
+       * a constraint tree (see check_options), since re-resolving could violate the constraint */
+      if (opts.pars_collapse_iters > 0 && !bs_rep && instance.constraint_tree.empty())
+      {
+        tree = Tree::improveParsimony(pars_msa, tree, random_seed, &score,
+                                      opts.pars_collapse_iters, opts.pars_collapse_seconds);
+
+        LOG_WORKER_TS(LogLevel::verbose) << "Improved PARSIMONY starting tree by collapse/resolve, score: "
+                                         << score << endl;
+      }
+
       break;
     }
     default:
@@ -1258,6 +1374,17 @@ void load_start_trees(RaxmlInstance& instance)
     assert(i == instance.opts.num_searches);
 }
 
+/* number of full ML searches (can be smaller than number of starting trees with triage) */
+size_t num_ml_searches(const Options& opts)
+{
+  if (opts.triage_top == 0 || opts.num_searches <= opts.triage_top ||
+      (opts.command != Command::search && opts.command != Command::all))
+    return opts.num_searches;
+
+  auto num_random = (size_t) ceil(RAXML_TRIAGE_RANDOM_FRACTION * (opts.num_searches - opts.triage_top));
+  return opts.triage_top + num_random;
+}
+
 void load_checkpoint(RaxmlInstance& instance, CheckpointManager& cm)
 {
   /* init checkpoint and set to the manager */
@@ -1289,11 +1416,16 @@ void load_checkpoint(RaxmlInstance& instance, CheckpointManager& cm)
     }
 
     /* determine if we are in ML tree search or in bootstrapping phase */
-    instance.run_phase = (ckpfile.ml_trees.size() >= instance.opts.num_searches) ?
+    instance.run_phase = (ckpfile.ml_trees.size() >= num_ml_searches(instance.opts)) ?
         RaxmlRunPhase::bootstrap : RaxmlRunPhase::mlsearch;
 
     ParallelContext::mpi_broadcast(instance.run_phase);
 
+    /* starting trees selected by triage in a previous run: tree indices in the checkpoint
+     * refer to this selection, so it must be reused as-is */
+    instance.triage_trees = ckpfile.triage_trees;
+    ParallelContext::mpi_broadcast(instance.triage_trees);
+
     /* gather in-progress tree ids */
     auto& in_work_trees = instance.run_phase == RaxmlRunPhase::bootstrap ?
         instance.done_bs_trees : instance.done_ml_trees;
@@ -1459,10 +1591,7 @@ void load_constraint(RaxmlInstance& instance)
 
 void build_parsimony_msa(RaxmlInstance& instance)
 {
-  unsigned int attrs = instance.opts.simd_arch;
-
-  // TODO: check if there is any reason not to use tip-inner
-  attrs |= PLL_ATTRIB_PATTERN_TIP;
+  auto attrs = parsimony_attributes(instance.opts);
 
   instance.parted_msa_parsimony.reset(new ParsimonyMSA(instance.parted_msa, attrs));
 }
@@ -1571,6 +1700,18 @@ void build_start_trees(RaxmlInstance& instance, unsigned int num_threads = 1)
   }
 }
 
+double part_site_weight(const RaxmlInstance& instance, size_t part_id)
+{
+  const auto& pinfo = instance.parted_msa->part_info(part_id);
+  double site_weight = pinfo.model().clv_entry_size();
+
+  /* with site repeats, only a fraction of CLV entries has to be computed */
+  if (instance.opts.use_repeats)
+    site_weight *= std::max(pinfo.repeats_ratio(), RAXML_REPEATS_MIN_WEIGHT);
+
+  return site_weight;
+}
+
 void balance_load(RaxmlInstance& instance)
 {
   PartitionAssignment part_sizes;
@@ -1579,12 +1720,24 @@ void balance_load(RaxmlInstance& instance)
   size_t i = 0;
   for (auto const& pinfo: instance.parted_msa->part_list())
   {
-    part_sizes.assign_sites(i, 0, pinfo.length(), pinfo.model().clv_entry_size());
+    part_sizes.assign_sites(i, 0, pinfo.length(), part_site_weight(instance, i));
+
+    if (instance.opts.use_repeats)
+    {
+      LOG_DEBUG << "Partition #" << i << ": estimated site repeats ratio: "
+                << pinfo.repeats_ratio() << endl;
+    }
     ++i;
   }
 
-  instance.proc_part_assign =
-      instance.load_balancer->get_all_assignments(part_sizes, ParallelContext::threads_per_group());
+  /* taxon-parallel SPR mode: every thread gets all sites */
+  if (instance.opts.use_spr_taxpar)
+    instance.proc_part_assign.assign(ParallelContext::threads_per_group(), part_sizes);
+  else
+  {
+    instance.proc_part_assign =
+        instance.load_balancer->get_all_assignments(part_sizes, ParallelContext::threads_per_group());
+  }
 
   LOG_INFO_TS << "Data distribution: " << PartitionAssignmentStats(instance.proc_part_assign) << endl;
   LOG_VERB << endl << instance.proc_part_assign;
@@ -1620,13 +1773,17 @@ PartitionAssignmentList balance_load(RaxmlInstance& instance, WeightVectorList p
     LOG_DEBUG << "Partition #" << i << ": " << comp_pos_map[i].size() << endl;
 
     /* add compressed partition length to the */
-    part_sizes.assign_sites(i, 0, comp_pos_map[i].size(),
-                            instance.parted_msa->model(i).clv_entry_size());
+    part_sizes.assign_sites(i, 0, comp_pos_map[i].size(), part_site_weight(instance, i));
     ++i;
   }
 
-  assign_list = instance.load_balancer->get_all_assignments(part_sizes,
-                                                            ParallelContext::threads_per_group());
+  if (instance.opts.use_spr_taxpar)
+    assign_list.assign(ParallelContext::threads_per_group(), part_sizes);
+  else
+  {
+    assign_list = instance.load_balancer->get_all_assignments(part_sizes,
+                                                              ParallelContext::threads_per_group());
+  }
 
   LOG_VERB_TS << "Data distribution: " << PartitionAssignmentStats(assign_list) << endl;
   LOG_DEBUG << endl << assign_list;
@@ -1709,27 +1866,28 @@ void generate_bootstraps(RaxmlInstance& instance, const CheckpointFile& checkp)
     if (instance.opts.use_par_pars)
       return;
 
-    /* generate starting trees for bootstrap searches */
-    auto start_tree_type = instance.opts.use_bs_pars ? StartingTree::parsimony : StartingTree::random;
+    /* generate replicate alignments */
+    BootstrapGenerator bg;
     for (size_t b = 0; b < instance.opts.num_bootstraps; ++b)
     {
-      auto tree = generate_tree(instance, start_tree_type, seeds[b]);
-
+//      /* check if this BS was already computed in the previous run and saved in checkpoint */
 //      if (b < checkp.bs_trees.size())
 //        continue;
 
-      instance.bs_start_trees.emplace_back(move(tree));
+      instance.bs_reps.emplace_back(bg.generate(*instance.parted_msa, seeds[b]));
     }
 
-    /* generate replicate alignments */
-    BootstrapGenerator bg;
+    /* generate starting trees for bootstrap searches */
+    auto start_tree_type = instance.opts.use_bs_pars ? StartingTree::parsimony : StartingTree::random;
     for (size_t b = 0; b < instance.opts.num_bootstraps; ++b)
     {
-//      /* check if this BS was already computed in the previous run and saved in checkpoint */
+      auto bs_rep = instance.opts.use_bs_rep_pars ? &instance.bs_reps.at(b) : nullptr;
+      auto tree = generate_tree(instance, start_tree_type, seeds[b], bs_rep);
+
 //      if (b < checkp.bs_trees.size())
 //        continue;
 
-      instance.bs_reps.emplace_back(bg.generate(*instance.parted_msa, seeds[b]));
+      instance.bs_start_trees.emplace_back(move(tree));
     }
   }
   RAXML_UNUSED(checkp); // might need it again for re-using previously computed replicates
@@ -2203,6 +2361,18 @@ void print_final_output(const RaxmlInstance& instance, const CheckpointFile& che
     LOG_RESULT << "Final LogLikelihood: " << FMT_LH(best_loglh) << endl;
     LOG_INFO << endl;
 
+    if (!checkp.abandoned_trees.empty())
+    {
+      LOG_INFO << "Abandoned ML searches (" << checkp.abandoned_trees.size() << " / " <<
+          checkp.ml_trees.size() << "):" << endl;
+      for (auto tree_index: checkp.abandoned_trees)
+      {
+        LOG_INFO << "  ML tree search #" << tree_index << ", logLikelihood: " <<
+            FMT_LH(checkp.ml_trees.at(tree_index).first) << endl;
+      }
+      LOG_INFO << endl;
+    }
+
     print_ic_scores(instance, best_loglh);
 
     Tree best_tree = instance.ml_tree.tree;
@@ -2549,9 +2719,17 @@ void init_parallel_buffers(const RaxmlInstance& instance)
 
   // we need 2 doubles for each partition AND threads to perform parallel reduction,
   // so resize the buffer accordingly
-  const size_t reduce_buffer_size = std::max<size_t>(1024u, 2 * sizeof(double) *
+  size_t reduce_buffer_size = std::max<size_t>(1024u, 2 * sizeof(double) *
                                      parted_msa.part_count() * ParallelContext::num_threads());
 
+  // taxon-parallel SPR: every thread sends its best moves (3 doubles each) to all other threads
+  if (opts.use_spr_taxpar)
+  {
+    reduce_buffer_size = std::max<size_t>(reduce_buffer_size, 3 * sizeof(double) *
+                                          RAXML_SPR_TAXPAR_MOVES * ParallelContext::num_threads() *
+                                          ParallelContext::num_threads());
+  }
+
   size_t worker_buf_size = 0;
   if (ParallelContext::num_ranks() > 1)
   {
@@ -2561,6 +2739,9 @@ void init_parallel_buffers(const RaxmlInstance& instance)
     // buffer needs enough space to store serialized model parameters
     worker_buf_size = model_size;
 
+    // ... and starting tree scores for triage
+    worker_buf_size = std::max(worker_buf_size, instance.start_trees.size() * sizeof(double) * 2);
+
     // for coarse-grained, add extra space to store ML/BS trees sent from workers to master
     if (ParallelContext::num_groups() > 1)
     {
@@ -2596,7 +2777,7 @@ void thread_infer_ml(RaxmlInstance& instance, CheckpointManager& cm)
         if (ParallelContext::group_master_thread())
           cm.gather_ml_trees();
 
-        ParallelContext::global_thread_barrier();
+        cm.sync_search_hints();
         batch_id++;
       }
     };
@@ -2613,6 +2794,15 @@ void thread_infer_ml(RaxmlInstance& instance, CheckpointManager& cm)
   {
     LOG_INFO << "\nStarting ML tree search with " << opts.num_searches <<
         " distinct starting trees" << endl;
+
+    /* trees are only exchanged between concurrent searches within the same MPI rank */
+    if (opts.use_search_coop && opts.num_searches > 1 &&
+        (ParallelContext::num_local_groups() < 2 || ParallelContext::ranks_per_group() > 1))
+    {
+      LOG_WARN << "\nWARNING: Cooperative tree search has no effect, since every MPI rank "
+                  "runs a single search at a time." << endl;
+      LOG_WARN << "NOTE:    Use more workers per rank (--workers) to enable tree exchange." << endl;
+    }
   }
 
   (instance.start_trees.size() > 1 ? LOG_RESULT : LOG_INFO) << endl;
@@ -2674,7 +2864,8 @@ void thread_infer_ml(RaxmlInstance& instance, CheckpointManager& cm)
       optimizer.optimize_topology(*treeinfo, cm);
       LOG_PROGR << endl;
       LOG_WORKER_TS(log_level) << "ML tree search #" << start_tree_num <<
-                           ", logLikelihood: " << FMT_LH(checkp.loglh()) << endl;
+                           ", logLikelihood: " << FMT_LH(checkp.loglh()) <<
+                           (optimizer.abandoned() ? " (abandoned)" : "") << endl;
       LOG_PROGR << endl;
     }
 
@@ -2688,7 +2879,7 @@ void thread_infer_ml(RaxmlInstance& instance, CheckpointManager& cm)
       treeinfo->persite_loglh(part_site_lh);
     }
 
-    cm.save_ml_tree();
+    cm.save_ml_tree(optimizer.abandoned());
     cm.reset_search_state();
 
     // coarse: collect ML trees from MPI workers
@@ -2698,6 +2889,9 @@ void thread_infer_ml(RaxmlInstance& instance, CheckpointManager& cm)
 
   gather_ml_trees(batch_id);
 
+  /* share auto-detected SPR radius with all workers for subsequent searches */
+  cm.sync_search_hints();
+
   if (opts.command == Command::ancestral)
   {
     assert(!opts.use_pattern_compression);
@@ -2706,6 +2900,108 @@ void thread_infer_ml(RaxmlInstance& instance, CheckpointManager& cm)
   }
 }
 
+/* Starting tree triage: every worker quickly scores its share of the starting trees,
+ * and full ML search is then conducted for the top-scoring trees plus a random subset.
+ * NB: full searches start from the original trees and not from the quick-scored ones:
+ * the latter would have to be collected from all ranks, and the search schedule
+ * (initial brlen optimization, radius detection etc.) would then differ from a run
+ * without triage. Quick scores are only used for ranking. */
+void thread_triage_start_trees(RaxmlInstance& instance, CheckpointManager& cm)
+{
+  auto const& opts = instance.opts;
+  auto const& master_msa = *instance.parted_msa;
+  const size_t num_trees = instance.start_trees.size();
+  const size_t num_selected = num_ml_searches(opts);
+  const size_t num_top = std::min<size_t>(opts.triage_top, num_selected);
+
+  /* when resuming from a checkpoint, reuse the original selection (if compatible) */
+  const auto& ckp_trees = instance.triage_trees;
+  const bool do_score = ckp_trees.size() != num_selected ||
+      std::any_of(ckp_trees.cbegin(), ckp_trees.cend(), [num_trees](size_t i) { return i >= num_trees; });
+
+  if (do_score)
+  {
+    if (ParallelContext::master_thread())
+      instance.triage_scores.assign(num_trees, -INFINITY);
+
+    ParallelContext::global_thread_barrier();
+
+    LOG_INFO << "\nStarting tree triage: scoring " << num_trees << " starting trees" << endl << endl;
+
+    auto const& part_assign = instance.proc_part_assign.at(ParallelContext::local_proc_id());
+    Optimizer optimizer(opts);
+    for (size_t i = ParallelContext::group_id(); i < num_trees; i += ParallelContext::num_groups())
+    {
+      TreeInfo treeinfo(opts, instance.start_trees.at(i), master_msa, instance.tip_msa_idmap,
+                        part_assign);
+      treeinfo.set_topology_constraint(instance.constraint_tree);
+
+      double loglh = optimizer.quick_score(treeinfo);
+      if (ParallelContext::group_master_thread())
+        instance.triage_scores[i] = loglh;
+
+      LOG_WORKER_TS(LogLevel::verbose) << "Starting tree #" << i+1 <<
+          ", quick logLikelihood: " << FMT_LH(loglh) << endl;
+    }
+
+    ParallelContext::global_thread_barrier();
+  }
+
+  if (ParallelContext::master_thread())
+  {
+    IDVector tree_ids(num_trees);
+    std::iota(tree_ids.begin(), tree_ids.end(), 0);
+
+    if (!do_score)
+      tree_ids = instance.triage_trees;
+    else
+    {
+      /* collect scores from all MPI ranks */
+      ParallelContext::mpi_reduce(instance.triage_scores.data(), num_trees, PLLMOD_COMMON_REDUCE_MAX);
+      ParallelContext::mpi_broadcast(instance.triage_scores);
+
+      const auto& scores = instance.triage_scores;
+      std::stable_sort(tree_ids.begin(), tree_ids.end(),
+                       [&scores](size_t a, size_t b) { return scores[a] > scores[b]; });
+
+      /* random subset of the remaining trees to keep diversity */
+      std::mt19937 gen(opts.random_seed);
+      std::shuffle(tree_ids.begin() + num_top, tree_ids.end(), gen);
+
+      tree_ids.resize(num_selected);
+      std::sort(tree_ids.begin(), tree_ids.end());
+
+      instance.triage_trees = tree_ids;
+    }
+
+    /* store selection in the checkpoint, tree indices used later on refer to it */
+    cm.update_triage_trees(tree_ids);
+
+    TreeList selected_trees;
+    for (auto i: tree_ids)
+      selected_trees.emplace_back(instance.start_trees.at(i));
+
+    instance.start_trees = std::move(selected_trees);
+    instance.opts.num_searches = num_selected;
+
+    balance_load_coarse(instance, cm.checkp_file());
+  }
+
+  ParallelContext::global_thread_barrier();
+
+  if (do_score)
+  {
+    LOG_INFO_TS << "Starting tree triage completed, selected " << num_selected << " out of " <<
+        num_trees << " starting trees (top: " << num_top << ", random: " << num_selected - num_top <<
+        ")" << endl;
+  }
+  else
+  {
+    LOG_INFO << "\nStarting tree triage: using " << num_selected << " out of " << num_trees <<
+        " starting trees selected in the previous run" << endl;
+  }
+}
+
 void thread_infer_bootstrap(RaxmlInstance& instance, CheckpointManager& cm)
 {
   auto const& opts = instance.opts;
@@ -2722,6 +3018,8 @@ void thread_infer_bootstrap(RaxmlInstance& instance, CheckpointManager& cm)
       if (ParallelContext::group_master_thread())
         cm.gather_bs_trees();
 
+      cm.sync_search_hints();
+
       /* check bootstrapping convergence */
       if (instance.bootstop_checker)
       {
@@ -2785,8 +3083,39 @@ void thread_infer_bootstrap(RaxmlInstance& instance, CheckpointManager& cm)
 
   auto ckp_tree_index = instance.run_phase == RaxmlRunPhase::bootstrap ? checkp.tree_index : 0;
 
+  /* ML model estimates are only available if ML search was conducted (--all) */
+  auto bs_opts = opts;
+
+  /* bootstrap searches are never abandoned, and replicates cannot exchange trees */
+  bs_opts.abandon_margin = 0.;
+  bs_opts.use_search_coop = false;
+
+  /* search trace only covers ML searches (tree indices would be ambiguous otherwise) */
+  bs_opts.use_search_trace = false;
+
+  const ModelMap * bs_models = nullptr;
+  if (opts.bs_model_init != BootstrapModelInit::initial)
+  {
+    if (opts.command == Command::all)
+    {
+      cm.broadcast_best_models();
+      bs_models = &cm.checkp_file().best_models;
+      if (opts.bs_model_init == BootstrapModelInit::fixed)
+        bs_opts.optimize_model = false;
+    }
+    else
+    {
+      LOG_WARN << "WARNING: ML model estimates are not available, bootstrap searches will "
+                  "start from the initial model parameters!" << endl << endl;
+    }
+  }
+
   ParallelContext::global_thread_barrier();
 
+  unsigned int bs_count = 0;
+  unsigned int bs_spr_rounds = 0;
+  double bs_start_time = global_timer().elapsed_seconds();
+
   BootstrapGenerator bg;
   auto start_tree_type = instance.opts.use_bs_pars ? StartingTree::parsimony : StartingTree::random;
   while (!instance.bs_converged && bs_num != worker.bs_trees.cend())
@@ -2796,8 +3125,9 @@ void thread_infer_bootstrap(RaxmlInstance& instance, CheckpointManager& cm)
       if (ParallelContext::group_master_thread())
       {
         auto bs_seed = instance.bs_seeds.at(*bs_num - 1);
-        worker.cur_bs_start_tree = generate_tree(instance, start_tree_type, bs_seed);
         worker.cur_bs_rep = bg.generate(*instance.parted_msa, bs_seed);
+        worker.cur_bs_start_tree = generate_tree(instance, start_tree_type, bs_seed,
+                                                 opts.use_bs_rep_pars ? &worker.cur_bs_rep : nullptr);
       }
       ParallelContext::thread_barrier();
     }
@@ -2819,7 +3149,7 @@ void thread_infer_bootstrap(RaxmlInstance& instance, CheckpointManager& cm)
     if (ckp_tree_index == *bs_num)
     {
       // restore search state from checkpoint (tree + model params)
-      treeinfo.reset(new TreeInfo(opts, checkp.tree, master_msa, instance.tip_msa_idmap,
+      treeinfo.reset(new TreeInfo(bs_opts, checkp.tree, master_msa, instance.tip_msa_idmap,
                                   bs_part_assign, worker.cur_bs_rep .site_weights));
       assign_models(*treeinfo, checkp);
     }
@@ -2827,14 +3157,18 @@ void thread_infer_bootstrap(RaxmlInstance& instance, CheckpointManager& cm)
     {
       if (ParallelContext::group_master_thread())
         checkp.tree_index = *bs_num;
-      treeinfo.reset(new TreeInfo(opts, worker.cur_bs_start_tree, master_msa, instance.tip_msa_idmap,
+      treeinfo.reset(new TreeInfo(bs_opts, worker.cur_bs_start_tree, master_msa, instance.tip_msa_idmap,
                                   bs_part_assign, worker.cur_bs_rep .site_weights));
+      if (bs_models)
+        assign_models(*treeinfo, *bs_models);
     }
 
     treeinfo->set_topology_constraint(instance.constraint_tree);
 
-    Optimizer optimizer(opts);
-    optimizer.optimize_topology(*treeinfo, cm);
+    Optimizer optimizer(bs_opts);
+    optimizer.optimize_topology(*treeinfo, cm, opts.use_rapid_bs);
+
+    bs_spr_rounds += optimizer.spr_rounds();
 
     LOG_PROGR << endl;
     LOG_WORKER_TS(LogLevel::info) << "Bootstrap tree #" << *bs_num <<
@@ -2845,6 +3179,7 @@ void thread_infer_bootstrap(RaxmlInstance& instance, CheckpointManager& cm)
     cm.reset_search_state();
 
     bs_num++;
+    bs_count++;
 
     if (bs_num == worker.bs_trees.cend() || *bs_num > bs_batch_end)
       gather_bs_trees(bs_batch_start, bs_batch_end);
@@ -2855,6 +3190,19 @@ void thread_infer_bootstrap(RaxmlInstance& instance, CheckpointManager& cm)
   /* special case: if this worker had no bsreps in last batch, it still must synchronize! */
   if (!instance.bs_converged && bs_batch_start < bs_batch_end)
     gather_bs_trees(bs_batch_start, bs_batch_end);
+
+  if (bs_count > 0)
+  {
+    double bs_time = global_timer().elapsed_seconds() - bs_start_time;
+    LOG_VERB << endl << "Bootstrap searches: " << bs_count << ", average time per replicate: "
+             << FMT_PREC3(bs_time / bs_count) << " seconds (model parameters: "
+             << (bs_models ? (bs_opts.optimize_model ? "ML estimates" : "ML estimates, fixed") : "initial")
+             << ", schedule: " << (opts.use_rapid_bs ? "rapid" : "full") << ")" << endl;
+    LOG_VERB << "Average number of SPR rounds per replicate: " << FMT_PREC3((double) bs_spr_rounds / bs_count)
+             << " (starting trees: " << (opts.use_bs_pars ? (opts.use_bs_rep_pars ?
+                                         "parsimony on replicate" : "parsimony") : "random")
+             << ")" << endl;
+  }
 }
 
 
@@ -2868,6 +3216,12 @@ void thread_main(RaxmlInstance& instance, CheckpointManager& cm)
 
   check_oversubscribe(instance);
 
+  if ((opts.command == Command::search || opts.command == Command::all) &&
+      instance.start_trees.size() > num_ml_searches(opts))
+  {
+    thread_triage_start_trees(instance, cm);
+  }
+
   if ((opts.command == Command::search || opts.command == Command::all ||
       opts.command == Command::evaluate || opts.command == Command::sitelh ||
       opts.command == Command::ancestral) &&
@@ -3012,6 +3366,17 @@ void master_main(RaxmlInstance& instance, CheckpointManager& cm)
     bs >> RBAStream::RBAOutput(parted_msa, RBAStream::RBAElement::seqdata, &local_part_ranges);
   }
 
+  /* switch to compact sequence storage: alignment checks and RBA output are done by now.
+   * Loading and pattern compression still work on plain (one byte per site) sequences,
+   * so this does not lower the peak memory usage during MSA loading */
+  if (opts.use_packed_msa)
+  {
+    const auto mem_plain = parted_msa.seq_mem_size();
+    parted_msa.pack_msa();
+    LOG_VERB << "Packed alignment storage (after loading): " << mem_plain / 1024 << " KB -> "
+             << parted_msa.seq_mem_size() / 1024 << " KB" << endl << endl;
+  }
+
   // TEMP WORKAROUND: here we reset random seed once again to make sure that BS replicates
   // are not affected by the number of ML search starting trees that has been generated before
   srand(instance.opts.random_seed);
@@ -3028,8 +3393,14 @@ void master_main(RaxmlInstance& instance, CheckpointManager& cm)
   if (ParallelContext::master_rank())
     instance.opts.remove_result_files();
 
+  /* one trace file per MPI rank; append records when resuming from a checkpoint */
+  if (opts.use_search_trace && !opts.nofiles_mode)
+    SearchTrace::open(opts.search_trace_file(), !opts.redo_mode);
+
   thread_main(instance, cm);
 
+  SearchTrace::close();
+
   if (ParallelContext::master_rank())
   {
     instance.ml_tree = cm.checkp_file().best_tree();
@@ -96,6 +96,13 @@ enum class LoadBalancing
   benoit
 };
 
+enum class BootstrapModelInit
+{
+  initial = 0,
+  warm,
+  fixed
+};
+
 enum class BranchSupportMetric
 {
   fbp = 0,
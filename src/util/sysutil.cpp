@@ -3,6 +3,7 @@
 #endif
 #include <sys/time.h>
 #include <sys/resource.h>
+#include <time.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #if defined __APPLE__
@@ -79,6 +80,21 @@ double sysutil_gettime()
 #endif
 }
 
+double sysutil_get_thread_cputime()
+{
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+  struct timespec ts;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+    return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+#endif
+
+  /* fallback: CPU time of the whole process */
+  struct rusage r_usage;
+  getrusage(RUSAGE_SELF, & r_usage);
+  return r_usage.ru_utime.tv_sec + r_usage.ru_utime.tv_usec * 1.0e-6 +
+         r_usage.ru_stime.tv_sec + r_usage.ru_stime.tv_usec * 1.0e-6;
+}
+
 void sysutil_show_rusage()
 {
   struct rusage r_usage;
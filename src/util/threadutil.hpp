@@ -0,0 +1,55 @@
+#ifndef RAXML_UTIL_THREADUTIL_HPP_
+#define RAXML_UTIL_THREADUTIL_HPP_
+
+#include <algorithm>
+#include <exception>
+#include <vector>
+
+#ifdef _RAXML_PTHREADS
+#include <thread>
+#endif
+
+/* Short-lived helper threads for data-parallel preprocessing (e.g. MSA parsing), which
+ * runs before the worker threads managed by ParallelContext are started.
+ * Calls fn(thread_idx, begin, end) on num_threads contiguous blocks of [0, n);
+ * an exception thrown in any block is re-thrown in the calling thread (earliest block first). */
+template<typename Func>
+void parallel_blocks(size_t n, unsigned int num_threads, Func fn)
+{
+  num_threads = (unsigned int) std::max<size_t>(1, std::min<size_t>(num_threads, n));
+
+#ifdef _RAXML_PTHREADS
+  if (num_threads > 1)
+  {
+    std::vector<std::thread> threads;
+    std::vector<std::exception_ptr> errors(num_threads);
+    for (unsigned int t = 0; t < num_threads; ++t)
+    {
+      threads.emplace_back([&fn, &errors, n, num_threads, t]()
+        {
+          try
+          {
+            fn(t, n * t / num_threads, n * (t + 1) / num_threads);
+          }
+          catch (...)
+          {
+            errors[t] = std::current_exception();
+          }
+        });
+    }
+
+    for (auto& thread: threads)
+      thread.join();
+
+    for (auto& e: errors)
+      if (e)
+        std::rethrow_exception(e);
+
+    return;
+  }
+#endif
+
+  fn(0, 0, n);
+}
+
+#endif /* RAXML_UTIL_THREADUTIL_HPP_ */
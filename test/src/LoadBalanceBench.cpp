@@ -0,0 +1,157 @@
+/*
+ * Standalone load balancer benchmark (not part of raxml_test).
+ *
+ * Generates synthetic phylogenomic partition layouts and reports assignment quality
+ * and runtime for all load balancers. Build with: make raxml_lb_bench
+ *
+ * Usage: raxml_lb_bench [full] [seed]
+ *   full  also run the large-scale scenario (100k partitions x 1024 threads)
+ */
+
+#include <chrono>
+#include <random>
+#include <memory>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+
+#include "src/loadbalance/LoadBalancer.hpp"
+
+using namespace std;
+
+struct BenchScenario
+{
+  string name;
+  size_t num_parts;
+  double log_mean;     /* lognormal parameters for partition length */
+  double log_sigma;
+  bool mixed_types;
+  vector<size_t> num_threads;
+};
+
+/* per-site weights as computed in balance_load(): states x rate categories */
+static double random_site_weight(mt19937& gen, bool mixed_types)
+{
+  const double DNA_WEIGHT = 4 * 4;
+  const double AA_WEIGHT = 20 * 4;
+  const double BIN_WEIGHT = 2 * 4;
+
+  if (!mixed_types)
+    return DNA_WEIGHT;
+
+  uniform_real_distribution<double> distr(0., 1.);
+  auto r = distr(gen);
+  if (r < 0.70)
+    return DNA_WEIGHT;
+  else if (r < 0.95)
+    return AA_WEIGHT;
+  else
+    return BIN_WEIGHT;
+}
+
+static PartitionAssignment generate_partitions(const BenchScenario& sc, unsigned int seed)
+{
+  mt19937 gen(seed);
+  lognormal_distribution<double> distr_len(sc.log_mean, sc.log_sigma);
+
+  PartitionAssignment part_sizes;
+  for (size_t i = 0; i < sc.num_parts; ++i)
+  {
+    const size_t psize = std::max<size_t>(1, (size_t) distr_len(gen));
+    const double pweight = random_site_weight(gen, sc.mixed_types);
+    part_sizes.assign_sites(i, 0, psize, pweight);
+  }
+
+  return part_sizes;
+}
+
+static void print_header()
+{
+  cout << left << setw(14) << "scenario" << right
+       << setw(8) << "parts" << setw(11) << "sites" << setw(7) << "thr"
+       << setw(10) << "balancer"
+       << setw(14) << "max_weight" << setw(14) << "min_weight" << setw(9) << "imbal"
+       << setw(10) << "max_parts" << setw(10) << "max_split" << setw(10) << "split_tot"
+       << setw(12) << "time_ms" << endl;
+}
+
+static void run_balancer(const BenchScenario& sc, const PartitionAssignment& part_sizes,
+                         size_t num_threads, const string& lb_name, LoadBalancer& lb)
+{
+  cout << left << setw(14) << sc.name << right
+       << setw(8) << part_sizes.num_parts() << setw(11) << part_sizes.length()
+       << setw(7) << num_threads << setw(10) << lb_name;
+
+  try
+  {
+    auto t_start = chrono::steady_clock::now();
+    auto pa_list = lb.get_all_assignments(part_sizes, num_threads);
+    auto t_end = chrono::steady_clock::now();
+
+    auto stats = PartitionAssignmentStats(pa_list);
+    auto opt_weight = part_sizes.weight() / num_threads;
+    auto imbalance = opt_weight > 0. ? stats.max_thread_weight / opt_weight : 0.;
+    auto time_ms = chrono::duration<double, milli>(t_end - t_start).count();
+
+    cout << fixed
+         << setw(14) << setprecision(0) << stats.max_thread_weight
+         << setw(14) << setprecision(0) << stats.min_thread_weight
+         << setw(9) << setprecision(3) << imbalance
+         << setw(10) << stats.max_thread_parts
+         << setw(10) << stats.max_thread_split_parts
+         << setw(10) << stats.total_split_parts
+         << setw(12) << setprecision(2) << time_ms << endl;
+  }
+  catch (exception& e)
+  {
+    cout << "  ERROR: " << e.what() << endl;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  bool run_full = false;
+  unsigned int seed = 42;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    string arg = argv[i];
+    if (arg == "full")
+      run_full = true;
+    else
+      seed = stoul(arg);
+  }
+
+  vector<BenchScenario> scenarios =
+  {
+    /* single-gene / small multi-gene datasets */
+    {"small-dna",      10, 7.0, 0.5, false, {2, 4, 16, 64}},
+    /* typical phylogenomic: thousands of genes, lognormal lengths, mixed data */
+    {"phylogenomic", 2000, 6.0, 0.8, true,  {4, 16, 64, 256}},
+    /* many short partitions, e.g. UCE loci */
+    {"short-loci",  10000, 5.0, 1.0, true,  {16, 128, 512}}
+  };
+
+  if (run_full)
+    scenarios.push_back({"large-scale", 100000, 6.0, 0.8, true, {256, 1024}});
+
+  vector<pair<string, unique_ptr<LoadBalancer>>> balancers;
+  balancers.emplace_back("naive", unique_ptr<LoadBalancer>(new SimpleLoadBalancer()));
+  balancers.emplace_back("kassian", unique_ptr<LoadBalancer>(new KassianLoadBalancer()));
+  balancers.emplace_back("benoit", unique_ptr<LoadBalancer>(new BenoitLoadBalancer()));
+
+  print_header();
+
+  for (const auto& sc: scenarios)
+  {
+    auto part_sizes = generate_partitions(sc, seed);
+    for (auto num_threads: sc.num_threads)
+    {
+      for (auto& lb: balancers)
+        run_balancer(sc, part_sizes, num_threads, lb.first, *lb.second);
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,359 @@
+#include "RaxmlTest.hpp"
+
+#include "src/io/file_io.hpp"
+
+using namespace std;
+
+static MSA read_fasta(const string& content, bool long_labels = false, unsigned int threads = 1)
+{
+  FastaStream fs(env->write_file("msa_stream_test.fa", content), long_labels);
+  fs.num_threads(threads);
+
+  MSA msa;
+  fs >> msa;
+  return msa;
+}
+
+static MSA read_phylip(const string& content, bool interleaved, unsigned int threads = 1)
+{
+  PhylipStream ps(env->write_file("msa_stream_test.phy", content), interleaved);
+  ps.num_threads(threads);
+
+  MSA msa;
+  ps >> msa;
+  return msa;
+}
+
+TEST(MSAStreamTest, fasta_basic)
+{
+  auto msa = read_fasta(">t1 comment\nACGT\nAC\n>t2\nAC GT\nA-\n\n>t3\n\nNNNNNN\n");
+
+  ASSERT_EQ(3, msa.size());
+  EXPECT_EQ(6, msa.length());
+  EXPECT_EQ("t1", msa.label(0));
+  EXPECT_EQ("ACGTAC", msa.at(0));
+  EXPECT_EQ("ACGTA-", msa.at(1));
+  EXPECT_EQ("NNNNNN", msa.at(2));
+}
+
+TEST(MSAStreamTest, fasta_crlf)
+{
+  auto msa = read_fasta(">t1\r\nACGT\r\nAC\r\n>t2 x\r\nACGTTT\r\n");
+
+  ASSERT_EQ(2, msa.size());
+  EXPECT_EQ("t1", msa.label(0));
+  EXPECT_EQ("t2", msa.label(1));
+  EXPECT_EQ("ACGTAC", msa.at(0));
+  EXPECT_EQ("ACGTTT", msa.at(1));
+}
+
+TEST(MSAStreamTest, fasta_long_labels)
+{
+  auto msa = read_fasta(">taxon one  \nACGT\n>taxon two\r\nACGA\n", true);
+
+  ASSERT_EQ(2, msa.size());
+  EXPECT_EQ("taxon_one", msa.label(0));
+  EXPECT_EQ("taxon_two", msa.label(1));
+}
+
+TEST(MSAStreamTest, fasta_errors)
+{
+  // unequal sequence lengths
+  EXPECT_THROW(read_fasta(">t1\nACGT\n>t2\nACG\n"), runtime_error);
+  EXPECT_THROW(read_fasta(">t1\nACGT\n>t2\nACGTA\n"), runtime_error);
+
+  // empty label
+  EXPECT_THROW(read_fasta(">t1\nACGT\n>\nACGT\n"), runtime_error);
+  EXPECT_THROW(read_fasta(">  \nACGT\n"), runtime_error);
+
+  // empty sequence
+  EXPECT_THROW(read_fasta(">t1\n\n>t2\nACGT\n"), runtime_error);
+  EXPECT_THROW(read_fasta(">t1\nACGT\n>t2\n"), runtime_error);
+
+  // illegal character / not a FASTA file
+  EXPECT_THROW(read_fasta(">t1\nAC\x01T\n"), runtime_error);
+  EXPECT_THROW(read_fasta("t1\nACGT\n"), runtime_error);
+}
+
+TEST(MSAStreamTest, fasta_multithreaded)
+{
+  // file must be larger than MSA_PARSE_MIN_CHUNK (4 MB) to be split across threads
+  const size_t taxa = 500;
+  const size_t sites = 30000;
+  const string chars = "ACGT-";
+
+  string content;
+  vector<string> seqs(taxa);
+  for (size_t i = 0; i < taxa; ++i)
+  {
+    auto& s = seqs[i];
+    for (size_t j = 0; j < sites; ++j)
+      s += chars[(i * 7 + j * 13 + j / 5) % chars.size()];
+
+    content += ">t" + to_string(i) + "\n";
+    for (size_t j = 0; j < sites; j += 70)
+      content += s.substr(j, 70) + (i % 2 ? "\r\n" : "\n");
+  }
+  ASSERT_GT(content.size(), 3 * 4 * 1024 * 1024);
+
+  auto msa1 = read_fasta(content, false, 1);
+  auto msa4 = read_fasta(content, false, 4);
+
+  ASSERT_EQ(taxa, msa1.size());
+  ASSERT_EQ(taxa, msa4.size());
+  for (size_t i = 0; i < taxa; ++i)
+  {
+    EXPECT_EQ("t" + to_string(i), msa4.label(i));
+    EXPECT_EQ(seqs[i], msa1.at(i));
+    EXPECT_EQ(seqs[i], msa4.at(i));
+  }
+}
+
+TEST(MSAStreamTest, phylip_sequential)
+{
+  auto msa = read_phylip("3 6\nt1 ACGTAC\nt2 ACG\nTA-\nt3\nNNN NNN\n", false);
+
+  ASSERT_EQ(3, msa.size());
+  EXPECT_EQ(6, msa.length());
+  EXPECT_EQ("t2", msa.label(1));
+  EXPECT_EQ("ACGTAC", msa.at(0));
+  EXPECT_EQ("ACGTA-", msa.at(1));
+  EXPECT_EQ("NNNNNN", msa.at(2));
+}
+
+TEST(MSAStreamTest, phylip_interleaved)
+{
+  auto msa = read_phylip(" 2 10\r\nt1 ACGTA\r\nt2 CCGTA\r\n\r\n\r\nTTTTT\r\nGG GGG\r\n", true);
+
+  ASSERT_EQ(2, msa.size());
+  EXPECT_EQ("t1", msa.label(0));
+  EXPECT_EQ("t2", msa.label(1));
+  EXPECT_EQ("ACGTATTTTT", msa.at(0));
+  EXPECT_EQ("CCGTAGGGGG", msa.at(1));
+}
+
+TEST(MSAStreamTest, phylip_errors)
+{
+  // invalid header
+  EXPECT_THROW(read_phylip("x 4\nt1 ACGT\n", true), runtime_error);
+  EXPECT_THROW(read_phylip("0 4\n", true), runtime_error);
+  EXPECT_THROW(read_phylip("\xe9 4\nt1 ACGT\n", false), runtime_error);
+
+  // sequence longer than specified in the header
+  EXPECT_THROW(read_phylip("2 4\nt1 ACGTA\nt2 ACGT\n", true), runtime_error);
+  EXPECT_THROW(read_phylip("2 4\nt1 ACGTA\nt2 ACGT\n", false), runtime_error);
+  EXPECT_THROW(read_phylip("2 4\nt1 AC\nGTAA\nt2 ACGT\n", false), runtime_error);
+
+  // sequence shorter than specified in the header
+  EXPECT_THROW(read_phylip("2 4\nt1 ACG\nt2 ACGT\n", false), runtime_error);
+  EXPECT_THROW(read_phylip("2 6\nt1 ACG\nt2 ACG\n\nTTT\n", true), runtime_error);
+}
+
+static MSA read_catg(const string& content, unsigned int threads = 1)
+{
+  CATGStream cs(env->write_file("msa_stream_test.catg", content));
+  cs.num_threads(threads);
+
+  MSA msa;
+  cs >> msa;
+  return msa;
+}
+
+TEST(MSAStreamTest, catg_basic)
+{
+  // probabilities are stored in CATG order -> remapped to ACGT
+  auto msa = read_catg("2 3\nt1 t2\n"
+                       "AC 0.1,0.7,0.1,0.1 0.7,0.1,0.1,0.1\n"
+                       "\n"
+                       "GT 0.1,0.1,0.2,0.6 0.25,0.25,0.25,0.25\n"
+                       "-N 1,1,1,1 1e-1,2.5E-1,.3,0.35\n");
+
+  ASSERT_EQ(2, msa.size());
+  ASSERT_EQ(3, msa.length());
+  EXPECT_EQ("t1", msa.label(0));
+  EXPECT_EQ("t2", msa.label(1));
+  EXPECT_EQ("AG-", msa.at(0));
+  EXPECT_EQ("CTN", msa.at(1));
+
+  ASSERT_EQ(4, msa.states());
+  const auto& probs = msa.probs();
+  EXPECT_DOUBLE_EQ(0.7, probs.get(0, 0, 0));
+  EXPECT_DOUBLE_EQ(0.1, probs.get(0, 0, 1));
+  EXPECT_DOUBLE_EQ(0.7, probs.get(1, 0, 1));
+  EXPECT_DOUBLE_EQ(0.6, probs.get(0, 1, 2));
+  EXPECT_DOUBLE_EQ(0.2, probs.get(0, 1, 3));
+  EXPECT_DOUBLE_EQ(0.25, probs.get(1, 2, 0));
+  EXPECT_DOUBLE_EQ(0.1, probs.get(1, 2, 1));
+  EXPECT_DOUBLE_EQ(0.35, probs.get(1, 2, 2));
+  EXPECT_DOUBLE_EQ(0.3, probs.get(1, 2, 3));
+}
+
+TEST(MSAStreamTest, catg_crlf)
+{
+  auto msa = read_catg("2 2\r\nt1 t2\r\nAC 0.1,0.7,0.1,0.1 0.7,0.1,0.1,0.1\r\n\r\n"
+                       "GT 0.1,0.1,0.2,0.6 0.1,0.1,0.6,0.2\r\n");
+
+  ASSERT_EQ(2, msa.size());
+  EXPECT_EQ("t2", msa.label(1));
+  EXPECT_EQ("AG", msa.at(0));
+  EXPECT_EQ("CT", msa.at(1));
+  EXPECT_DOUBLE_EQ(0.6, msa.probs().get(0, 1, 2));
+  EXPECT_DOUBLE_EQ(0.6, msa.probs().get(1, 1, 3));
+}
+
+TEST(MSAStreamTest, catg_errors)
+{
+  const string header = "2 2\nt1 t2\n";
+  const string site = "AC 0.1,0.7,0.1,0.1 0.7,0.1,0.1,0.1\n";
+
+  // invalid header / missing taxon labels
+  EXPECT_THROW(read_catg("0 2\nt1 t2\n" + site + site), runtime_error);
+  EXPECT_THROW(read_catg("2 2\nt1"), runtime_error);
+
+  // wrong number of sites
+  EXPECT_THROW(read_catg(header + site), runtime_error);
+  EXPECT_THROW(read_catg(header + site + site + site), runtime_error);
+
+  // wrong consensus length
+  EXPECT_THROW(read_catg(header + site + "A 0.1,0.7,0.1,0.1 0.7,0.1,0.1,0.1\n"), runtime_error);
+
+  // wrong number of states (first site defines it)
+  EXPECT_THROW(read_catg(header + site + "AC 0.1,0.7,0.1 0.7,0.1,0.1,0.1\n"), runtime_error);
+  EXPECT_THROW(read_catg(header + site + "AC 0.1,0.7,0.1,0.1 0.7,0.1,0.1,0.1,0.1\n"),
+               runtime_error);
+  EXPECT_THROW(read_catg(header + site + "AC 0.1,0.7,0.1,0.1\n"), runtime_error);
+
+  // invalid number
+  EXPECT_THROW(read_catg(header + site + "AC 0.1,0.7,x,0.1 0.7,0.1,0.1,0.1\n"), runtime_error);
+}
+
+TEST(MSAStreamTest, catg_multithreaded)
+{
+  // file must be larger than MSA_PARSE_MIN_CHUNK (4 MB) to be split across threads
+  const size_t taxa = 20;
+  const size_t sites = 40000;
+  const string chars = "ACGT";
+  const char * vals[] = {"0.1", "0.25", "0.7", "1"};
+
+  string content = to_string(taxa) + " " + to_string(sites) + "\n";
+  for (size_t i = 0; i < taxa; ++i)
+    content += "t" + to_string(i) + (i + 1 < taxa ? " " : "\n");
+  for (size_t j = 0; j < sites; ++j)
+  {
+    string cons(taxa, 'A'), line;
+    for (size_t i = 0; i < taxa; ++i)
+    {
+      cons[i] = chars[(i * 7 + j * 13 + j / 5) % chars.size()];
+      line += " ";
+      for (size_t k = 0; k < 4; ++k)
+        line += string(k ? "," : "") + vals[(i + j * 3 + k) % 4];
+    }
+    content += cons + line + (j % 2 ? "\r\n" : "\n");
+  }
+  ASSERT_GT(content.size(), 3 * 4 * 1024 * 1024);
+
+  auto msa1 = read_catg(content, 1);
+  auto msa4 = read_catg(content, 4);
+
+  ASSERT_EQ(taxa, msa1.size());
+  ASSERT_EQ(taxa, msa4.size());
+  ASSERT_EQ(sites, msa4.length());
+  for (size_t i = 0; i < taxa; ++i)
+  {
+    EXPECT_EQ("t" + to_string(i), msa4.label(i));
+    EXPECT_EQ(msa1.at(i), msa4.at(i));
+  }
+
+  // CATG -> ACGT: A <- file[1], C <- file[0]
+  EXPECT_DOUBLE_EQ(atof(vals[1]), msa4.probs().get(0, 0, 0));
+  EXPECT_DOUBLE_EQ(atof(vals[0]), msa4.probs().get(0, 0, 1));
+  for (size_t i = 0; i < taxa; ++i)
+    for (size_t j = 0; j < sites; ++j)
+      for (size_t k = 0; k < 4; ++k)
+        ASSERT_EQ(msa1.probs().get(i, j, k), msa4.probs().get(i, j, k));
+}
+
+static MSA read_vcf(const string& content)
+{
+  VCFStream vs(env->write_file("msa_stream_test.vcf", content));
+
+  MSA msa;
+  vs >> msa;
+  return msa;
+}
+
+static const string VCF_HEADER = "##fileformat=VCFv4.2\n##source=test\n"
+                                 "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\ts1\ts2\ts3\n";
+
+TEST(MSAStreamTest, vcf_basic)
+{
+  auto msa = read_vcf(VCF_HEADER +
+                      "1\t1\t.\tA\tG\t.\t.\t.\tGT\t0/0\t0/1\t1|1\n"           // phased + unphased
+                      "1\t2\t.\tA\tG\t.\t.\t.\tGT:DP\t0/0:3\t1|0:4\t1/1:5\n"  // same pattern
+                      "1\t3\t.\tAT\tA\t.\t.\t.\tGT\t0/0\t0/1\t1|1\n"          // indel -> skipped
+                      "1\t4\t.\tC\tT,G\t.\t.\t.\tGT\t2/1\t./.\t0\r\n"         // multi-allelic, haploid
+                      "1\t5\t.\tc\t.\t.\t.\t.\tGT\t0|.\t0\t0/0\n");           // no ALT, partially missing
+
+  ASSERT_EQ(3, msa.size());
+  EXPECT_EQ("s1", msa.label(0));
+  EXPECT_EQ("s3", msa.label(2));
+
+  // on-the-fly pattern compression: 4 SNV records -> 3 unique patterns
+  EXPECT_EQ(4, msa.num_sites());
+  ASSERT_EQ(3, msa.length());
+  EXPECT_EQ("AK-", msa.at(0));
+  EXPECT_EQ("R-C", msa.at(1));
+  EXPECT_EQ("GCC", msa.at(2));
+  EXPECT_EQ(WeightVector({2, 1, 1}), msa.weights());
+}
+
+TEST(MSAStreamTest, vcf_errors)
+{
+  // GT must be the first FORMAT key (GTX is not GT)
+  EXPECT_THROW(read_vcf(VCF_HEADER + "1\t1\t.\tA\tG\t.\t.\t.\tDP:GT\t3:0/0\t4:0/1\t5:1|1\n"),
+               runtime_error);
+  EXPECT_THROW(read_vcf(VCF_HEADER + "1\t1\t.\tA\tG\t.\t.\t.\tGTX\t0/0\t0/1\t1|1\n"),
+               runtime_error);
+
+  // wrong number of columns
+  EXPECT_THROW(read_vcf(VCF_HEADER + "1\t1\t.\tA\tG\t.\t.\t.\tGT\t0/0\t0/1\n"), runtime_error);
+
+  // invalid genotype / non-existing allele
+  EXPECT_THROW(read_vcf(VCF_HEADER + "1\t1\t.\tA\tG\t.\t.\t.\tGT\t0/0\t0/x\t1|1\n"), runtime_error);
+  EXPECT_THROW(read_vcf(VCF_HEADER + "1\t1\t.\tA\tG\t.\t.\t.\tGT\t0/0\t0/2\t1|1\n"), runtime_error);
+
+  // no single-nucleotide variants
+  EXPECT_THROW(read_vcf(VCF_HEADER + "1\t3\t.\tAT\tA\t.\t.\t.\tGT\t0/0\t0/1\t1|1\n"), runtime_error);
+
+  // missing header
+  EXPECT_THROW(read_vcf("1\t1\t.\tA\tG\t.\t.\t.\tGT\t0/0\t0/1\t1|1\n"), runtime_error);
+}
+
+static vector<FileFormat> sniff(const string& content)
+{
+  return msa_sniff_format(env->write_file("msa_stream_test.sniff", content));
+}
+
+TEST(MSAStreamTest, sniff_format)
+{
+  typedef vector<FileFormat> FV;
+
+  EXPECT_EQ(FV({FileFormat::fasta}), sniff("\n>t1\nACGT\n"));
+  EXPECT_EQ(FV({FileFormat::vcf}), sniff("##fileformat=VCFv4.2\n"));
+  EXPECT_EQ(FV({FileFormat::catg}), sniff("2 1\nt1 t2\nAC 0.1,0.2,0.3,0.4 1,1,1,1\n"));
+  EXPECT_EQ(FV(), sniff("x 4\nt1 ACGT\n"));
+
+  // PHYLIP: sequential vs. interleaved
+  EXPECT_EQ(FV({FileFormat::phylip}), sniff("3 6\nt1 ACGTAC\nt2 ACG\nTA-\nt3\nNNN NNN\n"));
+  EXPECT_EQ(FV({FileFormat::phylip}), sniff("2 10\nt1 ACGTA\r\nCC GTA\nt2 ACGTACCGTA\n"));
+  EXPECT_EQ(FV({FileFormat::iphylip}), sniff(" 2 10\r\nt1 ACGTA\r\nt2 CCGTA\r\n\r\nTTTTT\r\nGGGGG\r\n"));
+  EXPECT_EQ(FV({FileFormat::iphylip}), sniff("2 10\nt1 ACGTA\n\nTTTTT\n"));
+
+  // first record does not fit into the sniffer buffer
+  EXPECT_EQ(FV({FileFormat::phylip, FileFormat::iphylip}),
+            sniff("2 10000\nt1 " + string(10000, 'A') + "\nt2 " + string(10000, 'C') + "\n"));
+  string lines;
+  for (size_t i = 0; i < 200; ++i)
+    lines += string(50, 'A') + "\n";
+  EXPECT_EQ(FV({FileFormat::iphylip, FileFormat::phylip}), sniff("2 10000\nt1\n" + lines));
+}
@@ -0,0 +1,152 @@
+#include "RaxmlTest.hpp"
+
+#include "src/MSA.hpp"
+
+using namespace std;
+
+/* gaps/undetermined and T/U are written with different characters mapping to the same state */
+static const string MSA_TEST_CHARS = "ACGTU-NX?ORYKM";
+
+/* reference: copy sequences into a standalone pll_msa and compress it with libpll */
+static void compress_pll(const MSA& msa, const WeightVector& ext_weights,
+                         vector<string>& ref_seqs, WeightVector& ref_weights,
+                         WeightVector& ref_backmap)
+{
+  pll_msa_t * pll_msa = (pll_msa_t *) calloc(1, sizeof(pll_msa_t));
+  pll_msa->count = msa.size();
+  pll_msa->length = msa.length();
+  pll_msa->sequence = (char **) calloc(pll_msa->count, sizeof(char *));
+  pll_msa->label = (char **) calloc(pll_msa->count, sizeof(char *));
+  for (size_t i = 0; i < msa.size(); ++i)
+  {
+    pll_msa->sequence[i] = strdup(msa.at(i).c_str());
+    pll_msa->label[i] = strdup(msa.label(i).c_str());
+  }
+
+  ref_backmap.resize(msa.length());
+  unsigned int * w = pll_compress_site_patterns_msa(pll_msa, pll_map_nt, ref_backmap.data());
+  ASSERT_NE(nullptr, w);
+
+  const size_t length = pll_msa->length;
+  ref_seqs.clear();
+  for (size_t i = 0; i < msa.size(); ++i)
+    ref_seqs.emplace_back(pll_msa->sequence[i], length);
+
+  if (ext_weights.empty())
+    ref_weights.assign(w, w + length);
+  else
+  {
+    ref_weights.assign(length, 0);
+    for (size_t j = 0; j < ref_backmap.size(); ++j)
+      ref_weights[ref_backmap[j]] += ext_weights[j];
+  }
+
+  free(w);
+  pll_msa_destroy(pll_msa);
+}
+
+static void check_compress(size_t taxa, size_t sites, bool ext_weights, unsigned int num_threads)
+{
+  auto msa = env->random_msa(taxa, sites, 42 + sites, 1, MSA_TEST_CHARS);
+
+  WeightVector weights;
+  if (ext_weights)
+  {
+    for (size_t j = 0; j < sites; ++j)
+      weights.push_back(1 + j % 7);
+  }
+
+  vector<string> ref_seqs;
+  WeightVector ref_weights, ref_backmap;
+  compress_pll(msa, weights, ref_seqs, ref_weights, ref_backmap);
+
+  if (ext_weights)
+    msa.weights(weights);
+  msa.compress_patterns(pll_map_nt, true, num_threads);
+
+  // pattern order + (canonicalized) characters
+  ASSERT_EQ(ref_weights.size(), msa.num_patterns());
+  ASSERT_EQ(ref_weights.size(), msa.length());
+  for (size_t i = 0; i < taxa; ++i)
+    EXPECT_EQ(ref_seqs[i], msa.at(i)) << "taxon " << i;
+
+  // pattern weights
+  EXPECT_EQ(ref_weights, msa.weights());
+
+  // site -> pattern mapping
+  EXPECT_EQ(ref_backmap, msa.site_pattern_map());
+}
+
+TEST(MSATest, compress_patterns_1thread)
+{
+  check_compress(8, 2000, false, 1);
+}
+
+TEST(MSATest, compress_patterns_ext_weights)
+{
+  check_compress(8, 2000, true, 1);
+}
+
+TEST(MSATest, compress_patterns_multithread)
+{
+  // enough sites to use all threads (>= RAXML_PATCOMP_MIN_SITES per thread)
+  const unsigned int num_threads = 4;
+  const size_t sites = num_threads * RAXML_PATCOMP_MIN_SITES + 123;
+
+  check_compress(6, sites, false, num_threads);
+  check_compress(6, sites, true, num_threads);
+}
+
+TEST(MSATest, compress_patterns_threads_identical)
+{
+  const size_t sites = 3 * RAXML_PATCOMP_MIN_SITES;
+
+  auto msa1 = env->random_msa(5, sites, 7, 1, MSA_TEST_CHARS);
+  auto msa3 = env->random_msa(5, sites, 7, 1, MSA_TEST_CHARS);
+
+  msa1.compress_patterns(pll_map_nt, true, 1);
+  msa3.compress_patterns(pll_map_nt, true, 3);
+
+  ASSERT_EQ(msa1.length(), msa3.length());
+  for (size_t i = 0; i < msa1.size(); ++i)
+    EXPECT_EQ(msa1.at(i), msa3.at(i));
+  EXPECT_EQ(msa1.weights(), msa3.weights());
+  EXPECT_EQ(msa1.site_pattern_map(), msa3.site_pattern_map());
+}
+
+TEST(MSATest, compress_patterns_prob_freqs)
+{
+  const size_t taxa = 6;
+  const size_t sites = 3000;
+
+  /* probabilistic MSA with many repeated columns (incl. probabilities) */
+  MSA msa;
+  for (size_t i = 0; i < taxa; ++i)
+  {
+    string seq(sites, 'A');
+    for (size_t j = 0; j < sites; ++j)
+      seq[j] = "ACGT"[(i + j % 17) % 4];
+    msa.append(seq, "t" + to_string(i+1));
+  }
+
+  msa.states(4);
+  for (size_t i = 0; i < taxa; ++i)
+  {
+    for (size_t j = 0; j < sites; ++j)
+    {
+      const size_t s = (i + j % 17) % 4;
+      for (size_t k = 0; k < 4; ++k)
+        msa.probs().set(i, j, k, k == s ? 0.7 + 0.01 * (j % 5) : 0.1 - 0.01 * (j % 5) / 3.);
+    }
+  }
+
+  const auto ref_freqs = msa.state_freqs();
+
+  msa.compress_patterns(pll_map_nt, false, 1);
+  ASSERT_LT(msa.length(), sites);
+
+  const auto freqs = msa.state_freqs();
+  ASSERT_EQ(ref_freqs.size(), freqs.size());
+  for (size_t k = 0; k < freqs.size(); ++k)
+    EXPECT_NEAR(ref_freqs[k], freqs[k], 1e-10) << "state " << k;
+}
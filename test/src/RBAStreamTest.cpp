@@ -0,0 +1,278 @@
+#include "RaxmlTest.hpp"
+
+#include "src/io/file_io.hpp"
+#include "src/io/binary_io.hpp"
+
+using namespace std;
+
+/* enough taxa to get short column blocks (RBA_BLOCK_BYTES / taxa = 524 sites) */
+static const size_t RBA_TEST_TAXA = 2000;
+static const size_t RBA_TEST_BLOCK = 524;
+
+static PartitionedMSA rba_test_msa(bool with_weights)
+{
+  const size_t part_sites[] = {1200, 600};
+
+  PartitionedMSA pmsa;
+  size_t offset = 0;
+  for (size_t p = 0; p < 2; ++p)
+  {
+    const auto sites = part_sites[p];
+    auto msa = env->random_msa(RBA_TEST_TAXA, sites, p + 1, 1, "ACGT-N");
+
+    if (p == 0)
+      pmsa = PartitionedMSA(msa.labels());
+
+    const string range = to_string(offset+1) + "-" + to_string(offset+sites);
+    pmsa.emplace_part_info("p" + to_string(p+1), DataType::dna, "GTR+G", range);
+
+    if (with_weights)
+    {
+      WeightVector w(sites);
+      for (size_t j = 0; j < sites; ++j)
+        w[j] = 1 + (j + p) % 5;
+      msa.weights(w);
+    }
+
+    pmsa.part_list()[p].msa(std::move(msa));
+    offset += sites;
+  }
+
+  return pmsa;
+}
+
+static string rba_write(const PartitionedMSA& pmsa, const string& name, bool compress = true)
+{
+  auto fname = env->out_dir + name;
+  RBAStream rs(fname);
+  rs.compress(compress);
+  rs << pmsa;
+  return fname;
+}
+
+static void check_equal(const PartitionedMSA& ref, const PartitionedMSA& pmsa)
+{
+  ASSERT_EQ(ref.taxon_count(), pmsa.taxon_count());
+  ASSERT_EQ(ref.part_count(), pmsa.part_count());
+  EXPECT_EQ(ref.taxon_names(), pmsa.taxon_names());
+
+  for (size_t p = 0; p < ref.part_count(); ++p)
+  {
+    const auto& pref = ref.part_info(p);
+    const auto& pinfo = pmsa.part_info(p);
+
+    EXPECT_EQ(pref.name(), pinfo.name());
+    EXPECT_EQ(pref.range_string(), pinfo.range_string());
+    EXPECT_EQ(pref.model().to_string(), pinfo.model().to_string());
+
+    ASSERT_EQ(pref.msa().length(), pinfo.msa().length());
+    EXPECT_EQ(pref.msa().weights(), pinfo.msa().weights());
+    for (size_t i = 0; i < ref.taxon_count(); ++i)
+      ASSERT_EQ(pref.msa().sequence(i), pinfo.msa().sequence(i)) << "part " << p << ", taxon " << i;
+  }
+}
+
+TEST(RBAStreamTest, roundtrip)
+{
+  auto ref = rba_test_msa(true);
+  auto fname = rba_write(ref, "rba_test.rba");
+
+  EXPECT_TRUE(RBAStream::rba_file(fname, true));
+
+  // heap copy
+  {
+    PartitionedMSA pmsa;
+    RBAStream rs(fname);
+    rs.use_mmap(false);
+    rs >> pmsa;
+    check_equal(ref, pmsa);
+  }
+
+  // zero-copy (memory-mapped)
+  {
+    PartitionedMSA pmsa;
+    RBAStream rs(fname);
+    rs >> pmsa;
+    check_equal(ref, pmsa);
+  }
+}
+
+TEST(RBAStreamTest, roundtrip_nocompress)
+{
+  auto ref = rba_test_msa(false);
+  auto fname = rba_write(ref, "rba_test_nocomp.rba", false);
+
+  PartitionedMSA pmsa;
+  RBAStream rs(fname);
+  rs >> pmsa;
+  check_equal(ref, pmsa);
+
+  /* sanity check: uncompressed file can't be smaller than the alignment itself */
+  BinaryFileStream bos(fname, std::ios::in);
+  EXPECT_GE(bos.file_size(), RBA_TEST_TAXA * (1200 + 600));
+}
+
+TEST(RBAStreamTest, partial_load)
+{
+  auto ref = rba_test_msa(true);
+  auto fname = rba_write(ref, "rba_test_part.rba");
+
+  // ranges cross block boundaries (RBA_TEST_BLOCK) and the second partition is split
+  PartitionAssignment pa;
+  pa.assign_sites(0, 100, 50);
+  pa.assign_sites(0, RBA_TEST_BLOCK - 24, RBA_TEST_BLOCK + 48);
+  pa.assign_sites(1, RBA_TEST_BLOCK - 1, 2);
+
+  PartitionedMSA pmsa;
+  RBAStream rs(fname);
+  rs >> RBAStream::RBAOutput(pmsa, RBAStream::RBAElement::metadata, nullptr);
+  rs >> RBAStream::RBAOutput(pmsa, RBAStream::RBAElement::seqdata, &pa);
+
+  const auto& m0 = pmsa.part_info(0).msa();
+  const auto& r0 = ref.part_info(0).msa();
+  ASSERT_EQ(50 + RBA_TEST_BLOCK + 48, m0.length());
+  for (size_t i = 0; i < RBA_TEST_TAXA; ++i)
+  {
+    const auto& seq = r0.at(i);
+    EXPECT_EQ(seq.substr(100, 50) + seq.substr(RBA_TEST_BLOCK - 24, RBA_TEST_BLOCK + 48),
+              m0.sequence(i)) << "taxon " << i;
+  }
+
+  WeightVector w0(r0.weights().begin() + 100, r0.weights().begin() + 150);
+  w0.insert(w0.end(), r0.weights().begin() + RBA_TEST_BLOCK - 24,
+            r0.weights().begin() + 2 * RBA_TEST_BLOCK + 24);
+  EXPECT_EQ(w0, m0.weights());
+
+  const auto& m1 = pmsa.part_info(1).msa();
+  const auto& r1 = ref.part_info(1).msa();
+  ASSERT_EQ(2, m1.length());
+  for (size_t i = 0; i < RBA_TEST_TAXA; ++i)
+    EXPECT_EQ(r1.at(i).substr(RBA_TEST_BLOCK - 1, 2), m1.sequence(i)) << "taxon " << i;
+  EXPECT_EQ(WeightVector(r1.weights().begin() + RBA_TEST_BLOCK - 1,
+                         r1.weights().begin() + RBA_TEST_BLOCK + 1), m1.weights());
+
+  // site repeats estimate is stored in the file, i.e. it refers to the full alignment
+  for (size_t p = 0; p < ref.part_count(); ++p)
+    EXPECT_DOUBLE_EQ(ref.part_info(p).repeats_ratio(), pmsa.part_info(p).repeats_ratio());
+}
+
+TEST(RBAStreamTest, corrupted_block)
+{
+  auto ref = rba_test_msa(false);
+  auto fname = rba_write(ref, "rba_test_corrupt.rba", false);
+
+  // flip one byte in the middle of the file -> column data of the first partition
+  {
+    fstream fs(fname, ios::in | ios::out | ios::binary);
+    fs.seekg(0, ios::end);
+    const auto pos = fs.tellg() / 2;
+    fs.seekg(pos);
+    char c = fs.get();
+    fs.seekp(pos);
+    fs.put(c ^ 0x5A);
+  }
+
+  auto check_throw = [&fname](bool use_mmap, PartitionAssignment * pa)
+      {
+        PartitionedMSA pmsa;
+        RBAStream rs(fname);
+        rs.use_mmap(use_mmap);
+        if (pa)
+        {
+          rs >> RBAStream::RBAOutput(pmsa, RBAStream::RBAElement::metadata, nullptr);
+          rs >> RBAStream::RBAOutput(pmsa, RBAStream::RBAElement::seqdata, pa);
+        }
+        else
+          rs >> pmsa;
+      };
+
+  PartitionAssignment pa;
+  pa.assign_sites(0, 0, 1200);
+
+  EXPECT_THROW(check_throw(true, nullptr), runtime_error);
+  EXPECT_THROW(check_throw(false, nullptr), runtime_error);
+  EXPECT_THROW(check_throw(false, &pa), runtime_error);
+
+  try
+  {
+    check_throw(false, nullptr);
+  }
+  catch (runtime_error& e)
+  {
+    EXPECT_NE(string::npos, string(e.what()).find("CRC mismatch")) << e.what();
+  }
+}
+
+/* RBA v2: same header and metadata, followed by the serialized MSA of every partition */
+struct RBAv2Header
+{
+  uint64_t magic;
+  uint32_t version;
+  unsigned char sizet_size;
+  size_t taxon_count;
+  size_t pattern_count;
+  size_t site_count;
+  size_t part_count;
+};
+
+TEST(RBAStreamTest, read_v2)
+{
+  auto ref = rba_test_msa(true);
+  auto fname = env->out_dir + "rba_test_v2.rba";
+
+  {
+    BinaryFileStream bos(fname, std::ios::out);
+
+    RBAv2Header header{};
+    header.magic = *(reinterpret_cast<const uint64_t*>("RBAF\x13\x12\x17\x0A"));
+    header.version = 2;
+    header.sizet_size = sizeof(size_t);
+    header.taxon_count = ref.taxon_count();
+    header.site_count = 1200 + 600;
+    header.pattern_count = ref.total_patterns();
+    header.part_count = ref.part_count();
+    bos << header;
+
+    for (const auto& label: ref.taxon_names())
+      bos << label;
+
+    for (const auto& pinfo: ref.part_list())
+    {
+      bos << pinfo.name();
+      bos << pinfo.range_string();
+      bos << pinfo.stats();
+      bos << std::make_tuple(std::ref(pinfo.model()), ModelBinaryFmt::full);
+    }
+
+    for (const auto& pinfo: ref.part_list())
+      bos << pinfo.msa();
+  }
+
+  EXPECT_TRUE(RBAStream::rba_file(fname, true));
+
+  // full load
+  {
+    PartitionedMSA pmsa;
+    RBAStream rs(fname);
+    rs >> pmsa;
+    check_equal(ref, pmsa);
+  }
+
+  // partial load: second partition only
+  {
+    PartitionAssignment pa;
+    pa.assign_sites(1, 10, 500);
+
+    PartitionedMSA pmsa;
+    RBAStream rs(fname);
+    rs >> RBAStream::RBAOutput(pmsa, RBAStream::RBAElement::metadata, nullptr);
+    rs >> RBAStream::RBAOutput(pmsa, RBAStream::RBAElement::seqdata, &pa);
+
+    const auto& m1 = pmsa.part_info(1).msa();
+    const auto& r1 = ref.part_info(1).msa();
+    ASSERT_EQ(500, m1.length());
+    for (size_t i = 0; i < RBA_TEST_TAXA; ++i)
+      EXPECT_EQ(r1.at(i).substr(10, 500), m1.sequence(i));
+    EXPECT_EQ(WeightVector(r1.weights().begin() + 10, r1.weights().begin() + 510), m1.weights());
+  }
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <gtest/gtest.h>
+#include <fstream>
 
 #include "src/Options.hpp"
 
@@ -29,6 +30,45 @@ public:
     // before the destructor).
   }
 
+  // write a temporary input file into out_dir, returns the full file name
+  std::string write_file(const std::string& name, const std::string& content) const
+  {
+    auto fname = out_dir + name;
+    std::ofstream fs(fname, std::ios::out | std::ios::binary);
+    fs << content;
+    return fname;
+  }
+
+  // deterministic random alignment with taxon labels t1..tN: every taxon is derived from
+  // the same random ACGT sequence, and site j of taxon i is replaced by a random character
+  // from mut_chars with probability mut_pct * (i+1) %. This yields some phylogenetic
+  // signal and, for small mutation rates, many repeated site patterns.
+  MSA random_msa(size_t taxa, size_t sites, unsigned long seed, unsigned int mut_pct,
+                 const std::string& mut_chars = "ACGT") const
+  {
+    unsigned long state = seed;
+    auto rnd = [&state]() { state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+                            return (unsigned int) (state >> 33); };
+
+    std::string anc(sites, 'A');
+    for (auto& c: anc)
+      c = "ACGT"[rnd() % 4];
+
+    MSA msa(sites);
+    for (size_t i = 0; i < taxa; ++i)
+    {
+      std::string seq = anc;
+      for (auto& c: seq)
+      {
+        if (rnd() % 100 < mut_pct * (i+1))
+          c = mut_chars[rnd() % mut_chars.size()];
+      }
+      msa.append(seq, "t" + std::to_string(i+1));
+    }
+
+    return msa;
+  }
+
   // Objects declared here can be used by all tests in the test case for Foo.
   std::string data_dir;
   std::string out_dir;
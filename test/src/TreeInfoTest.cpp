@@ -0,0 +1,71 @@
+#include "RaxmlTest.hpp"
+
+#include "src/CommandLineParser.hpp"
+#include "src/TreeInfo.hpp"
+
+using namespace std;
+
+static PartitionedMSA treeinfo_test_msa(size_t taxa, size_t sites)
+{
+  auto msa = env->random_msa(taxa, sites, 12345, 3);
+
+  PartitionedMSA pmsa;
+  pmsa.emplace_part_info("p1", DataType::dna, "GTR+G");
+  pmsa.full_msa(std::move(msa));
+  pmsa.split_msa();
+  pmsa.compress_patterns();
+  pmsa.set_model_empirical_params();
+
+  return pmsa;
+}
+
+static Options treeinfo_test_opts(const string& extra)
+{
+  Options opts;
+  CommandLineParser parser;
+  string cmd = "raxml-ng --search --msa data.fa --model GTR+G --threads 1 --extra " + extra;
+
+  vector<char *> argv;
+  char * saveptr;
+  for (auto p = strtok_r(&cmd[0], " ", &saveptr); p; p = strtok_r(nullptr, " ", &saveptr))
+    argv.push_back(p);
+  argv.push_back(nullptr);
+
+  parser.parse_options(argv.size() - 1, argv.data(), opts);
+
+  return opts;
+}
+
+TEST(TreeInfoTest, spr_taxpar_thorough_lh_monotonic)
+{
+  auto pmsa = treeinfo_test_msa(12, 300);
+  auto opts = treeinfo_test_opts("spr-taxpar");
+
+  auto tree = Tree::buildRandom(pmsa.taxon_names(), 42);
+
+  PartitionAssignment part_assign;
+  part_assign.assign_sites(0, 0, pmsa.part_info(0).msa().length());
+
+  TreeInfo treeinfo(opts, tree, pmsa, IDVector(), part_assign);
+
+  double loglh = treeinfo.loglh();
+
+  spr_round_params params;
+  params.thorough = true;
+  params.radius_min = 1;
+  params.radius_max = 5;
+  params.ntopol_keep = 20;
+  params.subtree_cutoff = 0.;
+  params.lh_epsilon_brlen_full = 0.1;
+  params.lh_epsilon_brlen_triplet = 0.1;
+  params.reset_cutoff_info(loglh);
+
+  // rejected moves must leave the tree (incl. branch lengths) unchanged
+  for (size_t i = 0; i < 3; ++i)
+  {
+    auto new_loglh = treeinfo.spr_round(params);
+    EXPECT_GE(new_loglh, loglh - 1e-6) << "round " << i;
+    EXPECT_NEAR(new_loglh, treeinfo.loglh(), 1e-6);
+    loglh = new_loglh;
+  }
+}
@@ -17,6 +17,9 @@ int main(int argc, char** argv)
       env->data_dir = call.substr(0,found) + "/../data/";
   }
 
+  // temporary files written by the tests
+  env->out_dir = ::testing::TempDir();
+
 //  env->tree_file = std::string(env->data_dir);
 //  env->tree_file += "ref.tre";
 